@@ -0,0 +1,121 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+// Synthetic tree generator for the benchmark harness (make bench). Builds a
+// reproducible directory tree from a seed: every run with the same
+// parameters produces byte-identical layout, names and sizes, so timings
+// are comparable across commits.
+//
+// Usage:
+//   gentree --out DIR [--width N] [--depth N] [--files N]
+//           [--size-dist small|mixed|large] [--ignore-rate PCT] [--seed N]
+//
+//   width        directories per directory (default 4)
+//   depth        directory nesting levels (default 4)
+//   files        files per directory (default 20)
+//   size-dist    small: 0-4K, mixed: 0-256K skewed small, large: 1-16M
+//   ignore-rate  percentage of files named *.log, so --ignore="*.log"
+//                hits that fraction of entries (default 0)
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Config {
+  fs::path out;
+  int width = 4;
+  int depth = 4;
+  int files = 20;
+  std::string sizeDist = "small";
+  int ignoreRate = 0;
+  uint64_t seed = 42;
+};
+
+uintmax_t pick_size(const Config &cfg, std::mt19937_64 &rng) {
+  if (cfg.sizeDist == "large")
+    return std::uniform_int_distribution<uintmax_t>(1 << 20, 16u << 20)(rng);
+  if (cfg.sizeDist == "mixed") {
+    // Skew towards small files, as real source trees do.
+    const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    return static_cast<uintmax_t>(u * u * (256 * 1024));
+  }
+  return std::uniform_int_distribution<uintmax_t>(0, 4096)(rng);
+}
+
+void write_file(const fs::path &path, uintmax_t size, std::mt19937_64 &rng) {
+  std::ofstream out(path, std::ios::binary);
+  std::string line = "line ";
+  line += std::to_string(rng() % 1000);
+  line += '\n';
+  uintmax_t written = 0;
+  while (written < size) {
+    const size_t n = static_cast<size_t>(std::min<uintmax_t>(line.size(), size - written));
+    out.write(line.data(), static_cast<std::streamsize>(n));
+    written += n;
+  }
+}
+
+void generate(const Config &cfg, const fs::path &dir, int level, std::mt19937_64 &rng) {
+  fs::create_directories(dir);
+
+  for (int f = 0; f < cfg.files; ++f) {
+    const bool ignored =
+        cfg.ignoreRate > 0 &&
+        std::uniform_int_distribution<int>(0, 99)(rng) < cfg.ignoreRate;
+    std::string name = "file" + std::to_string(f);
+    name += ignored ? ".log" : ".txt";
+    write_file(dir / name, pick_size(cfg, rng), rng);
+  }
+
+  if (level >= cfg.depth)
+    return;
+  for (int d = 0; d < cfg.width; ++d)
+    generate(cfg, dir / ("dir" + std::to_string(d)), level + 1, rng);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Config cfg;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : ""; };
+    if (arg == "--out")
+      cfg.out = value();
+    else if (arg == "--width")
+      cfg.width = std::atoi(value());
+    else if (arg == "--depth")
+      cfg.depth = std::atoi(value());
+    else if (arg == "--files")
+      cfg.files = std::atoi(value());
+    else if (arg == "--size-dist")
+      cfg.sizeDist = value();
+    else if (arg == "--ignore-rate")
+      cfg.ignoreRate = std::atoi(value());
+    else if (arg == "--seed")
+      cfg.seed = std::strtoull(value(), nullptr, 10);
+    else {
+      std::fprintf(stderr, "gentree: unknown option '%s'\n", arg.c_str());
+      return 2;
+    }
+  }
+
+  if (cfg.out.empty()) {
+    std::fprintf(stderr, "gentree: --out DIR is required\n");
+    return 2;
+  }
+
+  std::mt19937_64 rng(cfg.seed);
+  generate(cfg, cfg.out, 1, rng);
+  return 0;
+}
@@ -0,0 +1,96 @@
+#!/bin/sh
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at https://mozilla.org/MPL/2.0/.
+#
+# Benchmark harness (invoked by `make bench`). Generates reproducible
+# synthetic trees with gentree, then runs each xtree scenario with one
+# warmup pass and $ITER timed iterations, reporting wall time, peak RSS
+# and (when strace is installed) total syscall counts.
+#
+# Environment:
+#   XTREE    path to the xtree binary          (default ./xtree)
+#   GENTREE  path to the gentree binary        (default ./build/bench/gentree)
+#   WORK     scratch directory for the trees   (default /tmp/xtree-bench)
+#   ITER     timed iterations per scenario     (default 5)
+
+set -e
+
+XTREE=${XTREE:-./xtree}
+GENTREE=${GENTREE:-./build/bench/gentree}
+WORK=${WORK:-/tmp/xtree-bench}
+ITER=${ITER:-5}
+
+now_ms() {
+  # POSIX date has no %N; python is already a build-host dependency of none,
+  # so fall back through the common options.
+  if [ -n "$EPOCHREALTIME" ]; then
+    echo "$EPOCHREALTIME" | awk -F. '{ printf "%d\n", $1 * 1000 + substr($2, 1, 3) }'
+  else
+    date +%s%3N
+  fi
+}
+
+run_scenario() {
+  tree=$1
+  label=$2
+  shift 2
+
+  # Warmup: populate page/dentry caches so iterations measure the tool.
+  "$XTREE" "$@" "$tree" > /dev/null 2>&1 || true
+
+  total=0
+  best=
+  i=0
+  while [ "$i" -lt "$ITER" ]; do
+    start=$(now_ms)
+    "$XTREE" "$@" "$tree" > /dev/null 2>&1
+    end=$(now_ms)
+    ms=$((end - start))
+    total=$((total + ms))
+    if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then best=$ms; fi
+    i=$((i + 1))
+  done
+  mean=$((total / ITER))
+
+  rss=n/a
+  if [ -x /usr/bin/time ]; then
+    rss=$( (/usr/bin/time -f '%M' "$XTREE" "$@" "$tree" > /dev/null) 2>&1 | tail -1 )
+  fi
+
+  syscalls=n/a
+  if command -v strace > /dev/null 2>&1; then
+    syscalls=$(strace -c -f -o /dev/stdout "$XTREE" "$@" "$tree" 2> /dev/null \
+               | awk 'END { print $4 }')
+  fi
+
+  printf '%-28s best %6s ms   mean %6s ms   rss %8s KB   syscalls %s\n' \
+         "$label" "$best" "$mean" "$rss" "$syscalls"
+}
+
+echo "== generating synthetic trees in $WORK (seed 42) =="
+rm -rf "$WORK"
+mkdir -p "$WORK"
+"$GENTREE" --out "$WORK/src"   --width 4 --depth 4 --files 20 --size-dist small --ignore-rate 20
+"$GENTREE" --out "$WORK/flat"  --width 1 --depth 1 --files 5000 --size-dist small
+"$GENTREE" --out "$WORK/deep"  --width 2 --depth 10 --files 4 --size-dist mixed
+
+if command -v git > /dev/null 2>&1; then
+  git -C "$WORK/src" init -q
+  git -C "$WORK/src" -c user.email=bench@local -c user.name=bench add -A
+  git -C "$WORK/src" -c user.email=bench@local -c user.name=bench commit -qm bench
+  echo '*.log' > "$WORK/src/.gitignore"
+fi
+
+echo "== $ITER iterations per scenario, 1 warmup =="
+run_scenario "$WORK/src"  "traverse"            --no-color
+run_scenario "$WORK/src"  "traverse --ignore"   --no-color --ignore "*.log"
+run_scenario "$WORK/src"  "--size"              --no-color --size
+run_scenario "$WORK/src"  "--du"                --no-color --du
+run_scenario "$WORK/src"  "--du --threads 0"    --no-color --du --threads 0
+run_scenario "$WORK/src"  "--stats"             --no-color --stats
+run_scenario "$WORK/flat" "flat 5k --size"      --no-color --size
+run_scenario "$WORK/deep" "deep --du"           --no-color --du
+if command -v git > /dev/null 2>&1; then
+  run_scenario "$WORK/src" "--git"              --no-color --git
+fi
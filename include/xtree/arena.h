@@ -0,0 +1,53 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace xtree {
+
+// Bump allocator for the per-run string data (entry names and paths). A
+// scan allocates millions of small strings that all die together at the end
+// of the run, so they are carved out of large blocks and released wholesale
+// instead of hitting the general-purpose allocator per entry. Not
+// thread-safe: the parallel scanner gives each worker its own arena.
+class Arena {
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  // Copies `s` into the arena and returns a view of the stored bytes. The
+  // copy is NUL-terminated, so view.data() is usable as a C string.
+  std::string_view store(std::string_view s) {
+    char *p = alloc(s.size() + 1);
+    std::memcpy(p, s.data(), s.size());
+    p[s.size()] = '\0';
+    return {p, s.size()};
+  }
+
+private:
+  static constexpr size_t kBlockSize = 64 * 1024;
+
+  char *alloc(size_t n) {
+    if (blocks_.empty() || used_ + n > blockSize_) {
+      blockSize_ = n > kBlockSize ? n : kBlockSize;
+      blocks_.push_back(std::make_unique<char[]>(blockSize_));
+      used_ = 0;
+    }
+    char *p = blocks_.back().get() + used_;
+    used_ += n;
+    return p;
+  }
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  size_t blockSize_ = 0;
+  size_t used_ = 0;
+};
+
+} // namespace xtree
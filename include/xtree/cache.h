@@ -0,0 +1,61 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace xtree {
+
+namespace fs = std::filesystem;
+
+// On-disk size cache for repeat --du runs (enabled with --cache). Each
+// directory record is keyed by its path and mtime and stores the sizes of
+// its direct regular files, so a warm run over an unchanged tree needs only
+// readdir plus one mtime check per directory instead of a stat per file.
+// Like any mtime-keyed cache it cannot see a file rewritten in place
+// without its directory changing; the target use case is mostly-static
+// artifact trees where that does not happen.
+class SizeCache {
+public:
+  // Per-file record; dev/ino/nlink are kept so hardlink dedup keeps
+  // working when sizes come from the cache instead of a fresh stat.
+  struct FileRecord {
+    uintmax_t size = 0;
+    uint64_t dev = 0;
+    uint64_t ino = 0;
+    uint64_t nlink = 1;
+  };
+
+  struct DirRecord {
+    int64_t mtime = 0;
+    std::unordered_map<std::string, FileRecord> fileSizes;
+  };
+
+  // Loads the previous run's records; missing or unreadable files simply
+  // leave the cache cold. Returns false on a format mismatch.
+  bool load(const fs::path &file);
+  bool save(const fs::path &file) const;
+
+  // Returns the record for `dirPath` when its stored mtime matches, else null.
+  const DirRecord *find(const std::string &dirPath, int64_t mtime) const;
+
+  // Records the directory as seen by the current scan. Thread-safe, so the
+  // parallel scanner's workers can publish records directly.
+  void put(const std::string &dirPath, DirRecord record);
+
+private:
+  std::unordered_map<std::string, DirRecord> loaded_;
+  std::unordered_map<std::string, DirRecord> current_;
+  mutable std::mutex mutex_;
+};
+
+// Cache file name placed in the scanned root.
+constexpr const char *kSizeCacheFileName = ".xtree.cache";
+
+} // namespace xtree
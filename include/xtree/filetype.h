@@ -0,0 +1,147 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace xtree {
+
+// Coarse file classes for per-type name colorization. Classification runs
+// per entry in the printer's hottest loop, so the extension table is built
+// entirely at compile time: an open-addressed hash over string_views of the
+// known extensions, probed case-insensitively against the filename tail.
+// A lookup is one hash plus a few compares, with zero allocations.
+
+enum class FileType : uint8_t { Other, Source, Image, Archive, Executable };
+
+namespace detail {
+
+constexpr char fold_char(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr uint32_t ext_hash(std::string_view ext) {
+  // FNV-1a over the case-folded extension.
+  uint32_t h = 2166136261u;
+  for (char c : ext) {
+    h ^= static_cast<uint8_t>(fold_char(c));
+    h *= 16777619u;
+  }
+  return h;
+}
+
+constexpr bool ext_equal(std::string_view candidate, std::string_view known) {
+  if (candidate.size() != known.size())
+    return false;
+  for (size_t i = 0; i < candidate.size(); ++i)
+    if (fold_char(candidate[i]) != known[i])
+      return false;
+  return true;
+}
+
+struct ExtEntry {
+  std::string_view ext; // stored lowercase
+  FileType type;
+};
+
+constexpr ExtEntry kKnownExtensions[] = {
+    // Source code and scripts.
+    {"c", FileType::Source},       {"h", FileType::Source},
+    {"cc", FileType::Source},      {"hh", FileType::Source},
+    {"cpp", FileType::Source},     {"hpp", FileType::Source},
+    {"cxx", FileType::Source},     {"hxx", FileType::Source},
+    {"cs", FileType::Source},      {"java", FileType::Source},
+    {"py", FileType::Source},      {"rb", FileType::Source},
+    {"go", FileType::Source},      {"rs", FileType::Source},
+    {"js", FileType::Source},      {"ts", FileType::Source},
+    {"jsx", FileType::Source},     {"tsx", FileType::Source},
+    {"sh", FileType::Source},      {"bash", FileType::Source},
+    {"zsh", FileType::Source},     {"pl", FileType::Source},
+    {"lua", FileType::Source},     {"php", FileType::Source},
+    {"swift", FileType::Source},   {"kt", FileType::Source},
+    {"m", FileType::Source},       {"mm", FileType::Source},
+    {"scala", FileType::Source},   {"hs", FileType::Source},
+    {"ml", FileType::Source},      {"sql", FileType::Source},
+    {"r", FileType::Source},       {"jl", FileType::Source},
+    {"zig", FileType::Source},     {"d", FileType::Source},
+    {"nim", FileType::Source},     {"dart", FileType::Source},
+    {"asm", FileType::Source},     {"s", FileType::Source},
+    // Images.
+    {"png", FileType::Image},      {"jpg", FileType::Image},
+    {"jpeg", FileType::Image},     {"gif", FileType::Image},
+    {"bmp", FileType::Image},      {"svg", FileType::Image},
+    {"ico", FileType::Image},      {"webp", FileType::Image},
+    {"tiff", FileType::Image},     {"tif", FileType::Image},
+    {"heic", FileType::Image},     {"avif", FileType::Image},
+    {"psd", FileType::Image},      {"xcf", FileType::Image},
+    // Archives and packages.
+    {"zip", FileType::Archive},    {"tar", FileType::Archive},
+    {"gz", FileType::Archive},     {"bz2", FileType::Archive},
+    {"xz", FileType::Archive},     {"zst", FileType::Archive},
+    {"7z", FileType::Archive},     {"rar", FileType::Archive},
+    {"tgz", FileType::Archive},    {"txz", FileType::Archive},
+    {"lz4", FileType::Archive},    {"jar", FileType::Archive},
+    {"deb", FileType::Archive},    {"rpm", FileType::Archive},
+    {"apk", FileType::Archive},    {"iso", FileType::Archive},
+    {"a", FileType::Archive},
+    // Executables and loadable objects.
+    {"exe", FileType::Executable}, {"dll", FileType::Executable},
+    {"so", FileType::Executable},  {"dylib", FileType::Executable},
+    {"bin", FileType::Executable}, {"msi", FileType::Executable},
+    {"com", FileType::Executable}, {"appimage", FileType::Executable},
+};
+
+// Power of two, ~4x the entry count, so probe chains stay at a few slots.
+constexpr size_t kTableSize = 512;
+constexpr size_t kLongestExt = 8; // "appimage"; longer tails can't match
+
+struct ExtTable {
+  std::string_view ext[kTableSize]{};
+  FileType type[kTableSize]{};
+
+  constexpr ExtTable() {
+    for (const auto &entry : kKnownExtensions) {
+      size_t slot = ext_hash(entry.ext) & (kTableSize - 1);
+      while (!ext[slot].empty())
+        slot = (slot + 1) & (kTableSize - 1);
+      ext[slot] = entry.ext;
+      type[slot] = entry.type;
+    }
+  }
+};
+
+inline constexpr ExtTable kExtTable{};
+
+} // namespace detail
+
+// Classifies `name` by the extension after its last dot. Dotfiles
+// (".gitignore") and extensionless names are Other.
+constexpr FileType classify_file_type(std::string_view name) {
+  const size_t dot = name.rfind('.');
+  if (dot == std::string_view::npos || dot == 0 || dot + 1 == name.size())
+    return FileType::Other;
+
+  const std::string_view ext = name.substr(dot + 1);
+  if (ext.size() > detail::kLongestExt)
+    return FileType::Other;
+
+  size_t slot = detail::ext_hash(ext) & (detail::kTableSize - 1);
+  while (!detail::kExtTable.ext[slot].empty()) {
+    if (detail::ext_equal(ext, detail::kExtTable.ext[slot]))
+      return detail::kExtTable.type[slot];
+    slot = (slot + 1) & (detail::kTableSize - 1);
+  }
+  return FileType::Other;
+}
+
+static_assert(classify_file_type("main.cpp") == FileType::Source);
+static_assert(classify_file_type("photo.JPG") == FileType::Image);
+static_assert(classify_file_type("dist.tar") == FileType::Archive);
+static_assert(classify_file_type("libfoo.so") == FileType::Executable);
+static_assert(classify_file_type(".gitignore") == FileType::Other);
+static_assert(classify_file_type("README") == FileType::Other);
+
+} // namespace xtree
@@ -20,9 +20,21 @@ struct FileGitInfo {
   std::string date;
 };
 
+// With `useCache`, consults an on-disk snapshot of the previous run's
+// parsed status (see kGitStatusCacheFileName) keyed by .git/HEAD content and
+// .git/index mtime+size, and skips every git subprocess on a hit.
 bool get_git_status(const std::filesystem::path &target, std::filesystem::path &repo_root,
                     std::unordered_map<std::string, FileGitInfo> &fileStatus,
                     std::unordered_map<std::string, char> &dirStatus,
-                    std::vector<std::string> &branches);
+                    std::vector<std::string> &branches, bool useCache = false);
+
+// Cache file name placed in the repo root, alongside .xtree.cache.
+constexpr const char *kGitStatusCacheFileName = ".xtree.gitcache";
+
+// Shared by the subprocess and libgit2 backends (git_common.cpp): folds the
+// per-file statuses up into one summary letter per directory, the
+// highest-priority status winning.
+void build_directory_status(const std::unordered_map<std::string, FileGitInfo> &fileStatus,
+                            std::unordered_map<std::string, char> &dirStatus);
 
 } // namespace xtree
\ No newline at end of file
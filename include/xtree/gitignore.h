@@ -0,0 +1,57 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xtree {
+
+namespace fs = std::filesystem;
+
+// In-process .gitignore engine, replacing the `--ignored` flag previously
+// passed to the git status subprocess (which forced git to enumerate and
+// serialize every ignored path over the pipe). Parses .git/info/exclude and
+// per-directory .gitignore files on demand, honoring their scoping: deeper
+// files override shallower ones, later rules override earlier ones, and
+// entries inside an ignored directory are ignored outright.
+//
+// Supported syntax: comments, blank lines, '!' negation, trailing-'/'
+// directory-only rules, leading-'/' or embedded-'/' anchoring, and
+// '*', '?', '**' wildcards ('*'/'?' do not cross path separators).
+class GitignoreMatcher {
+public:
+  explicit GitignoreMatcher(fs::path repoRoot);
+
+  // `relPath` is the path relative to the repo root using '/' separators.
+  // Not thread-safe: the per-directory rule cache mutates on lookup.
+  bool is_ignored(const std::string &relPath, bool isDir) const;
+
+private:
+  struct Rule {
+    std::string pattern;
+    bool negate = false;
+    bool dirOnly = false;
+    bool anchored = false;
+  };
+
+  struct RuleSet {
+    std::vector<Rule> rules;
+  };
+
+  // Rules for the repo-relative directory `relDir` ("" = root), loaded and
+  // cached on first use.
+  const RuleSet *dir_rules(const std::string &relDir) const;
+
+  static void parse_file(const fs::path &file, RuleSet &out);
+
+  fs::path root_;
+  RuleSet excludeRules_; // .git/info/exclude, evaluated before root rules
+  mutable std::unordered_map<std::string, RuleSet> cache_;
+};
+
+} // namespace xtree
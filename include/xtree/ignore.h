@@ -0,0 +1,36 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace xtree {
+
+// Ignore patterns compiled once at startup into O(1) lookups: a hash set
+// for exact filenames, a hash set for extensions, and a small list of
+// wildcard patterns ('*'/'?') matched with an iterative glob walk. Matching
+// is case-insensitive, like the linear scans it replaces.
+class IgnoreMatcher {
+public:
+  // Classifies each pattern: wildcards go to the glob list, everything else
+  // is matched both as an exact filename and (sans leading dot) as an
+  // extension, preserving the historical --ignore semantics.
+  void compile(const std::vector<std::string> &patterns);
+
+  bool empty() const { return names_.empty() && extensions_.empty() && globs_.empty(); }
+
+  // `filename` is the entry's final component, any case.
+  bool matches(std::string_view filename) const;
+
+private:
+  std::unordered_set<std::string> names_;
+  std::unordered_set<std::string> extensions_;
+  std::vector<std::string> globs_;
+};
+
+} // namespace xtree
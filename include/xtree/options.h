@@ -4,11 +4,15 @@
 
 #pragma once
 
+#include "xtree/ignore.h"
+
 #include <string>
 #include <vector>
 
 namespace xtree {
 
+enum class OutputFormat { Tree, Json, Ndjson };
+
 struct Options {
   int maxDepth = -1;
   bool showHidden = false;
@@ -17,8 +21,19 @@ struct Options {
   bool useColor = true;
   bool followSymlinks = false;
   std::vector<std::string> ignorePatterns;
+  IgnoreMatcher ignoreMatcher; // compiled from ignorePatterns after parsing
   bool gitStatus = false;
   bool diskUsage = false;
+  bool duShallow = false; // --du limited to --depth; boundary dirs get partial sizes
+  int threads = 1;      // scanner threads; 0 = one per hardware core
+  bool useCache = false; // persist/reuse file sizes via .xtree.cache
+  bool fastFirst = false; // --du/--stats: print structure first, totals after
+  bool watch = false;     // stay resident and re-render on inotify events
+  bool naturalSort = false; // case-folded, numeric-aware name ordering
+  bool oneFileSystem = false; // do not descend into other filesystems
+  bool profile = false;   // emit a per-phase timing summary to stderr
+  int topN = 0;           // --top N: report only the N largest entries
+  OutputFormat format = OutputFormat::Tree;
 };
 
 } // namespace xtree
@@ -2,21 +2,56 @@
 #pragma once
 
 #include "xtree/options.h"
+#include "xtree/scanner.h"
+#include "xtree/writer.h"
 #include <filesystem>
 #include <string>
 #include <unordered_map>
 
 #include "xtree/git.h"
+#include "xtree/gitignore.h"
 
 namespace xtree {
 
 namespace fs = std::filesystem;
 
-void print_tree(const fs::path &path, const Options &opts,
-                const std::unordered_map<std::string, uintmax_t> &dirSizes,
-                const fs::path &repo_root,
+// `gitKey` is the repo-relative key of `node` itself ("" for the repo root);
+// children extend it with "/<name>" so git map lookups never touch the
+// filesystem.
+void print_tree(const ScanNode &node, const Options &opts, OutputWriter &out,
                 const std::unordered_map<std::string, FileGitInfo> *fileStatus,
-                const std::unordered_map<std::string, char> *dirStatus, int depth = 0,
-                std::string prefix = "");
+                const std::unordered_map<std::string, char> *dirStatus,
+                const GitignoreMatcher *gitignore = nullptr, const std::string &gitKey = "",
+                int depth = 0, std::string prefix = "");
+
+// Streaming variant for runs that need no subtree aggregates (--du/--stats):
+// lists, prints and releases one directory at a time instead of
+// materializing the scanned tree, keeping peak memory proportional to the
+// recursion path rather than the total entry count.
+void stream_tree(const fs::path &path, const Options &opts, OutputWriter &out,
+                 const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                 const std::unordered_map<std::string, char> *dirStatus,
+                 const GitignoreMatcher *gitignore = nullptr, const std::string &gitKey = "",
+                 int depth = 0, std::string prefix = "");
+
+// Machine-readable counterparts for --format=json/--format=ndjson: one
+// record per entry (path, type, depth, size and git status when known),
+// streamed through the same buffered writer. print_json renders a scanned
+// tree, stream_json walks the filesystem directly like stream_tree.
+void print_json(const ScanNode &root, const Options &opts, OutputWriter &out,
+                const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                const std::unordered_map<std::string, char> *dirStatus,
+                const GitignoreMatcher *gitignore = nullptr, const std::string &rootKey = "");
+
+void stream_json(const fs::path &path, const Options &opts, OutputWriter &out,
+                 const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                 const std::unordered_map<std::string, char> *dirStatus,
+                 const GitignoreMatcher *gitignore = nullptr, const std::string &rootKey = "");
+
+// --top N: prints only the N largest files and directories under the
+// scanned root, largest first, instead of the tree. Selection runs over the
+// aggregated scan with a bounded min-heap, so memory stays O(N) no matter
+// how many entries the walk saw.
+void print_top(const ScanNode &root, const Options &opts, OutputWriter &out);
 
 } // namespace xtree
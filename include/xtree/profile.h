@@ -0,0 +1,62 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace xtree {
+namespace prof {
+
+// Lightweight phase profiler behind --profile. Every probe is guarded by
+// one predictable branch on `enabled`, so with the flag off the hot paths
+// pay a single untaken compare — no clock reads, no atomics. Phase times
+// are summed across scanner workers, so they can exceed wall time.
+
+enum class Phase {
+  List,   // directory enumeration + filtering
+  Sort,   // entry ordering
+  Stat,   // per-file size/identity stats (batched or not)
+  Lines,  // line counting for --stats
+  Git,    // git subprocess spawns (time includes child runtime)
+  Output, // flushing formatted output to stdout
+  Count_
+};
+
+extern bool enabled; // set once at startup, before any worker thread
+
+void add(Phase phase, uint64_t ns);
+void add_entries(uint64_t n);
+void add_bytes(uint64_t n);
+
+// Summary table, written to stderr when the run finishes.
+void report(std::ostream &out);
+
+// Accumulates into `phase` for the enclosing scope when profiling is on.
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Phase phase) : phase_(phase) {
+    if (enabled)
+      start_ = std::chrono::steady_clock::now();
+  }
+
+  ~ScopedTimer() {
+    if (enabled)
+      add(phase_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now() - start_)
+                                            .count()));
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Phase phase_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace prof
+} // namespace xtree
@@ -0,0 +1,53 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "xtree/arena.h"
+#include "xtree/options.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace xtree {
+
+namespace fs = std::filesystem;
+
+// One entry discovered during the single traversal pass. Directories carry
+// aggregates (size, file/line counts) for their whole subtree so --du and
+// --stats can be answered without re-walking the filesystem.
+struct ScanNode {
+  // Views into the owning ScanResult's arenas; NUL-terminated, so .data()
+  // can be handed to filesystem calls directly.
+  std::string_view name;
+  std::string_view path;
+  bool isDir = false;
+  bool otherFs = false;    // directory on another filesystem, not descended
+  uintmax_t size = 0;      // file size; for directories, total size of all files inside
+  uintmax_t fileCount = 0; // directories only: regular files in the subtree
+  uintmax_t lineCount = 0; // directories only: lines in the subtree (when --stats)
+  uint64_t dev = 0;        // identity for hardlink dedup (files, when sized)
+  uint64_t ino = 0;
+  uintmax_t nlink = 1;
+  std::vector<ScanNode> children;
+};
+
+struct ScanResult {
+  ScanNode root;
+  uintmax_t totalFiles = 0;
+  uintmax_t totalLines = 0;
+  uintmax_t totalSize = 0;
+  // Backing storage for every node's name/path; one arena per scan worker,
+  // released wholesale when the result goes out of scope.
+  std::vector<std::unique_ptr<Arena>> arenas;
+};
+
+// Walks the tree once and returns the node structure. File sizes are stat'ed
+// only when --size or --du needs them, and lines are counted only for --stats.
+ScanResult scan_tree(const fs::path &root, const Options &opts);
+
+} // namespace xtree
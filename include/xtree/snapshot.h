@@ -0,0 +1,44 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "xtree/options.h"
+#include "xtree/scanner.h"
+
+#include <filesystem>
+
+namespace xtree {
+
+namespace fs = std::filesystem;
+
+// Flat binary snapshot of a scanned tree (--save/--load). Nodes are stored
+// in preorder with their name, path, type and aggregates; all strings are
+// written NUL-terminated so a loaded tree's string_views point straight
+// into the mapping with no copying. Re-displaying an 800GB artifact store
+// thus costs one mmap instead of a multi-minute walk.
+
+// Owns the bytes a loaded ScanResult's views point into; must outlive the
+// result. Uses mmap where available, a heap buffer elsewhere.
+class SnapshotMapping {
+public:
+  SnapshotMapping() = default;
+  ~SnapshotMapping();
+  SnapshotMapping(const SnapshotMapping &) = delete;
+  SnapshotMapping &operator=(const SnapshotMapping &) = delete;
+
+  const char *data = nullptr;
+  size_t size = 0;
+  bool mapped = false; // true: munmap on destruction; false: delete[]
+};
+
+bool save_snapshot(const fs::path &file, const ScanResult &scan);
+
+// Rebuilds the node structure from `file`, applying the run's --all and
+// --ignore filters while descending so a snapshot can be re-filtered
+// without rescanning. Returns false on open or format errors.
+bool load_snapshot(const fs::path &file, const Options &opts, ScanResult &out,
+                   SnapshotMapping &mapping);
+
+} // namespace xtree
@@ -0,0 +1,38 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xtree {
+
+// Batches file-size stats for the streaming --size path. On Linux with
+// io_uring the whole directory's statx calls are submitted as one ring
+// batch, so metadata round-trips overlap instead of serializing — on NFS
+// this turns one RTT per file into roughly one per directory. Elsewhere,
+// or when the kernel rejects io_uring, sizes() degrades to sequential
+// stats with identical results.
+class StatBatcher {
+public:
+  struct Result {
+    uintmax_t size = 0;
+    int error = 0; // errno; non-zero means the file could not be stat'ed
+  };
+
+  StatBatcher();
+  ~StatBatcher();
+  StatBatcher(const StatBatcher &) = delete;
+  StatBatcher &operator=(const StatBatcher &) = delete;
+
+  // Fills out[i] for each path. The paths must stay valid for the call.
+  void sizes(const std::vector<std::string> &paths, std::vector<Result> &out);
+
+private:
+  void *ring_ = nullptr; // io_uring state; null means sequential fallback
+};
+
+} // namespace xtree
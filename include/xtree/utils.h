@@ -22,18 +22,30 @@ std::string color_gray(const std::string &s, bool color);
 
 std::string color_red(const std::string &s, bool color);
 std::string color_yellow(const std::string &s, bool color);
+std::string color_magenta(const std::string &s, bool color);
+std::string color_cyan(const std::string &s, bool color);
 
 std::string human_size(uintmax_t size);
 std::string normalize_path(const std::string &p);
 
 bool should_ignore(const fs::path &path, const Options &opts);
-std::vector<fs::directory_entry> get_filtered_entries(const fs::path &path, const Options &opts);
 
-uintmax_t compute_dir_size(const fs::path &path, const Options &opts,
-                           std::unordered_map<std::string, uintmax_t> &dirSizes);
-
-void compute_project_stats(const fs::path &path, const Options &opts, uintmax_t &fileCount,
-                           uintmax_t &lineCount);
+// One filtered, classified directory entry. On Linux the type flags come
+// straight from the dirent d_type field, so listing a directory normally
+// costs no stat calls at all; other platforms (and DT_UNKNOWN filesystems)
+// fall back to the portable iterator/stat path.
+struct FilteredEntry {
+  std::string name;
+  bool isDir = false;
+  bool isRegular = false;
+};
+
+std::vector<FilteredEntry> get_filtered_entries(const fs::path &path, const Options &opts);
+
+// Device id of `p` for --one-file-system mount-boundary checks; 0 when it
+// cannot be determined (also on platforms without stat), which disables
+// pruning for that entry rather than hiding it.
+uint64_t device_of(const fs::path &p);
 
 void parse_ignore_patterns(const std::string &input, std::vector<std::string> &patterns);
 
@@ -0,0 +1,24 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "xtree/options.h"
+#include "xtree/writer.h"
+
+#include <filesystem>
+
+namespace xtree {
+
+namespace fs = std::filesystem;
+
+// --watch: scans once, keeps the node tree resident, and applies
+// inotify events incrementally — only directories that actually received
+// events are re-listed, so steady-state cost tracks churn rather than tree
+// size. Each batch of events triggers a full-screen re-render from the
+// in-memory tree. Runs until interrupted; returns the process exit code.
+// Linux-only (inotify); other platforms get an error message.
+int run_watch(const fs::path &target, const Options &opts, OutputWriter &out);
+
+} // namespace xtree
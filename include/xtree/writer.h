@@ -0,0 +1,43 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace xtree {
+
+enum class Color { None, Blue, Green, Gray, Red, Yellow, Magenta, Cyan };
+
+// Accumulates output in one reusable buffer and flushes it to stdout in
+// large chunks, so a big tree costs a handful of write syscalls instead of
+// several per line. Colored fragments are appended piecewise (escape code,
+// text, reset) to avoid the temporary string concatenations the printer
+// used to build.
+class OutputWriter {
+public:
+  explicit OutputWriter(size_t flushThreshold = 64 * 1024);
+  ~OutputWriter();
+
+  OutputWriter(const OutputWriter &) = delete;
+  OutputWriter &operator=(const OutputWriter &) = delete;
+
+  OutputWriter &write(std::string_view s);
+  OutputWriter &write(char c);
+  OutputWriter &colored(Color color, std::string_view s, bool useColor);
+  // Writes " (s)" with the parentheses inside the color span, the common
+  // annotation shape for sizes and git statuses.
+  OutputWriter &annotation(Color color, std::string_view s, bool useColor);
+
+  void flush();
+
+private:
+  void maybe_flush();
+
+  std::string buf_;
+  size_t threshold_;
+};
+
+} // namespace xtree
@@ -5,23 +5,71 @@
 #include "xtree/git.h"
 #include "xtree/options.h"
 #include "xtree/printer.h"
+#include "xtree/profile.h"
+#include "xtree/scanner.h"
+#include "xtree/snapshot.h"
 #include "xtree/utils.h"
+#include "xtree/watcher.h"
+#include "xtree/writer.h"
 
+#include <charconv>
 #include <filesystem>
-#include <functional>
 #include <iostream>
+#include <optional>
 #include <sstream>
-#include <stdexcept>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// Repo-relative key of the scanned root, seed for the incremental git keys.
+std::string rootKeyFor(bool gitOk, const fs::path &target, const fs::path &repo_root) {
+  if (!gitOk)
+    return {};
+  std::string key = xtree::normalize_path(fs::relative(target, repo_root).generic_string());
+  if (key == ".")
+    key.clear();
+  return key;
+}
+
+// One boolean option: long spelling, optional short letter (combinable as
+// in -asL) and the Options member it sets. The table is constexpr, so
+// matching an argv element is a linear scan over string_views — no map, no
+// std::function, no heap allocation on the startup path.
+struct BoolFlag {
+  std::string_view longName;
+  char shortName; // '\0' when the option has no short form
+  bool xtree::Options::*field;
+  bool value; // what to assign; false for --no-color
+};
+
+constexpr BoolFlag kBoolFlags[] = {
+    {"--all", 'a', &xtree::Options::showHidden, true},
+    {"--size", 's', &xtree::Options::showSize, true},
+    {"--no-color", '\0', &xtree::Options::useColor, false},
+    {"--follow-links", 'L', &xtree::Options::followSymlinks, true},
+    {"--git", 'g', &xtree::Options::gitStatus, true},
+    {"--stats", '\0', &xtree::Options::showStats, true},
+    {"--du", 'd', &xtree::Options::diskUsage, true},
+    {"--du-shallow", '\0', &xtree::Options::duShallow, true},
+    {"--cache", '\0', &xtree::Options::useCache, true},
+    {"--fast-first", '\0', &xtree::Options::fastFirst, true},
+    {"--watch", '\0', &xtree::Options::watch, true},
+    {"--natural-sort", '\0', &xtree::Options::naturalSort, true},
+    {"--one-file-system", 'x', &xtree::Options::oneFileSystem, true},
+    {"--profile", '\0', &xtree::Options::profile, true},
+};
+
+} // namespace
+
 int main(int argc, char *argv[]) {
   using namespace xtree;
 
   for (int i = 1; i < argc; ++i) {
-    std::string arg = argv[i];
-    if (arg == "--help") {
+    if (std::string_view(argv[i]) == "--help") {
       print_help();
       return 0;
     }
@@ -29,39 +77,101 @@ int main(int argc, char *argv[]) {
 
   Options opts;
   fs::path target = ".";
-  bool target_set = false;
-
-  auto parse_depth_arg = [&](const std::string &raw, Options &o) -> bool {
-    try {
-      size_t pos = 0;
-      int value = std::stoi(raw, &pos);
-      if (pos != raw.size() || value < 0) {
-        throw std::invalid_argument("invalid depth");
-      }
-      o.maxDepth = value;
-      return true;
-    } catch (const std::exception &) {
+  std::vector<fs::path> targets;
+  std::string savePath;
+  std::string loadPath;
+
+  // from_chars keeps integer parsing allocation- and exception-free.
+  auto parse_int = [](std::string_view raw, int &value) -> bool {
+    const char *end = raw.data() + raw.size();
+    const auto result = std::from_chars(raw.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end;
+  };
+
+  auto parse_depth_arg = [&](std::string_view raw, Options &o) -> bool {
+    int value = 0;
+    if (!parse_int(raw, value) || value < 0) {
       std::cerr << "Invalid value for --depth: '" << raw << "'. Expected a non-negative integer.\n";
       return false;
     }
+    o.maxDepth = value;
+    return true;
   };
 
-  const std::unordered_map<std::string, std::function<void(Options &, int &, int, char **)>>
-      option_handlers = {
-          {"--all", [](Options &o, int &, int, char **) { o.showHidden = true; }},
-          {"--size", [](Options &o, int &, int, char **) { o.showSize = true; }},
-          {"--no-color", [](Options &o, int &, int, char **) { o.useColor = false; }},
-          {"--follow-links", [](Options &o, int &, int, char **) { o.followSymlinks = true; }},
-          {"--git", [](Options &o, int &, int, char **) { o.gitStatus = true; }},
-          {"--stats", [](Options &o, int &, int, char **) { o.showStats = true; }},
-          {"--du", [](Options &o, int &, int, char **) { o.diskUsage = true; }},
-          {"--ignore", [](Options &o, int &i, int argc, char **argv) {
-             if (i + 1 < argc)
-               parse_ignore_patterns(argv[++i], o.ignorePatterns);
-           }}};
+  auto parse_format_arg = [&](std::string_view raw, Options &o) -> bool {
+    if (raw == "tree")
+      o.format = OutputFormat::Tree;
+    else if (raw == "json")
+      o.format = OutputFormat::Json;
+    else if (raw == "ndjson")
+      o.format = OutputFormat::Ndjson;
+    else {
+      std::cerr << "Invalid value for --format: '" << raw << "'. Expected tree, json or ndjson.\n";
+      return false;
+    }
+    return true;
+  };
+
+  auto parse_top_arg = [&](std::string_view raw, Options &o) -> bool {
+    int value = 0;
+    if (!parse_int(raw, value) || value <= 0) {
+      std::cerr << "Invalid value for --top: '" << raw << "'. Expected a positive integer.\n";
+      return false;
+    }
+    o.topN = value;
+    return true;
+  };
+
+  auto parse_threads_arg = [&](std::string_view raw, Options &o) -> bool {
+    int value = 0;
+    if (!parse_int(raw, value) || value < 0) {
+      std::cerr << "Invalid value for --threads: '" << raw
+                << "'. Expected a non-negative integer.\n";
+      return false;
+    }
+    o.threads = value;
+    return true;
+  };
+
+  auto apply_long_flag = [&](std::string_view arg) -> bool {
+    for (const auto &flag : kBoolFlags) {
+      if (arg == flag.longName) {
+        opts.*(flag.field) = flag.value;
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Combined short flags: every letter after the dash must be a known short
+  // option (-a, -s, -asL). Validated before applying, so a typo like -az
+  // rejects the whole argument instead of half-applying it.
+  auto apply_short_flags = [&](std::string_view arg) -> bool {
+    const std::string_view letters = arg.substr(1);
+    for (char c : letters) {
+      bool known = false;
+      for (const auto &flag : kBoolFlags)
+        known = known || flag.shortName == c;
+      if (!known)
+        return false;
+    }
+    for (char c : letters)
+      for (const auto &flag : kBoolFlags)
+        if (flag.shortName == c)
+          opts.*(flag.field) = flag.value;
+    return true;
+  };
+
+  auto take_value = [&](const char *name, int &i) -> const char * {
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << name << ".\n";
+      return nullptr;
+    }
+    return argv[++i];
+  };
 
   for (int i = 1; i < argc; ++i) {
-    std::string arg = argv[i];
+    const std::string_view arg = argv[i];
 
     if (arg.rfind("--depth=", 0) == 0) {
       if (!parse_depth_arg(arg.substr(8), opts))
@@ -79,33 +189,207 @@ int main(int argc, char *argv[]) {
       continue;
     }
 
+    if (arg.rfind("--format=", 0) == 0) {
+      if (!parse_format_arg(arg.substr(9), opts))
+        return 2;
+      continue;
+    }
+
+    if (arg == "--format") {
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value for --format.\n";
+        return 2;
+      }
+      if (!parse_format_arg(argv[++i], opts))
+        return 2;
+      continue;
+    }
+
+    if (arg.rfind("--top=", 0) == 0) {
+      if (!parse_top_arg(arg.substr(6), opts))
+        return 2;
+      continue;
+    }
+
+    if (arg == "--top") {
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value for --top.\n";
+        return 2;
+      }
+      if (!parse_top_arg(argv[++i], opts))
+        return 2;
+      continue;
+    }
+
+    if (arg.rfind("--threads=", 0) == 0) {
+      if (!parse_threads_arg(arg.substr(10), opts))
+        return 2;
+      continue;
+    }
+
+    if (arg == "--threads") {
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value for --threads.\n";
+        return 2;
+      }
+      if (!parse_threads_arg(argv[++i], opts))
+        return 2;
+      continue;
+    }
+
     if (arg.rfind("--ignore=", 0) == 0) {
-      parse_ignore_patterns(arg.substr(9), opts.ignorePatterns);
+      parse_ignore_patterns(std::string(arg.substr(9)), opts.ignorePatterns);
       continue;
     }
 
-    if (arg == "--ignore" && i + 1 >= argc) {
-      std::cerr << "Missing value for --ignore.\n";
-      return 2;
+    if (arg == "--ignore") {
+      const char *value = take_value("--ignore", i);
+      if (!value)
+        return 2;
+      parse_ignore_patterns(value, opts.ignorePatterns);
+      continue;
     }
 
-    auto it = option_handlers.find(arg);
-    if (it != option_handlers.end()) {
-      it->second(opts, i, argc, argv);
-    } else {
-      if (!arg.empty() && arg[0] == '-') {
+    if (arg.rfind("--save=", 0) == 0) {
+      savePath = std::string(arg.substr(7));
+      continue;
+    }
+    if (arg == "--save") {
+      const char *value = take_value("--save", i);
+      if (!value)
+        return 2;
+      savePath = value;
+      continue;
+    }
+    if (arg.rfind("--load=", 0) == 0) {
+      loadPath = std::string(arg.substr(7));
+      continue;
+    }
+    if (arg == "--load") {
+      const char *value = take_value("--load", i);
+      if (!value)
+        return 2;
+      loadPath = value;
+      continue;
+    }
+
+    if (!arg.empty() && arg[0] == '-') {
+      const bool matched = arg.size() < 2    ? false
+                           : arg[1] == '-' ? apply_long_flag(arg)
+                                           : apply_short_flags(arg);
+      if (!matched) {
         std::cerr << "Unknown option: " << arg << "\n";
         std::cerr << "Use --help to see available options.\n";
         return 2;
       }
-      if (!target_set) {
-        target = arg;
-        target_set = true;
-      } else {
-        std::cerr << "Unexpected extra positional argument: " << arg << "\n";
-        return 2;
+      continue;
+    }
+
+    targets.emplace_back(std::string(arg));
+  }
+
+  if (targets.size() == 1)
+    target = targets.front();
+
+  opts.ignoreMatcher.compile(opts.ignorePatterns);
+
+  // --top needs aggregated directory sizes, exactly what --du computes.
+  if (opts.topN > 0)
+    opts.diskUsage = true;
+
+  // --du-shallow is --du with the walk pruned at the display depth.
+  if (opts.duShallow)
+    opts.diskUsage = true;
+
+  // Set before any worker thread starts; the probes only read the flag.
+  prof::enabled = opts.profile;
+
+  // Multiple roots: scan (and collect git status for) every PATH
+  // concurrently, then emit the trees in argument order through the shared
+  // writer, so a dashboard refresh costs the slowest root rather than the
+  // sum and a single process startup.
+  if (targets.size() > 1) {
+    if (opts.watch || !savePath.empty() || !loadPath.empty()) {
+      std::cerr << "--watch, --save and --load support a single PATH.\n";
+      return 2;
+    }
+
+    struct RootJob {
+      fs::path target;
+      ScanResult scan;
+      fs::path repoRoot;
+      std::unordered_map<std::string, FileGitInfo> fileStatus;
+      std::unordered_map<std::string, char> dirStatus;
+      std::vector<std::string> branches;
+      bool gitOk = false;
+    };
+
+    std::vector<RootJob> jobs(targets.size());
+    std::vector<std::thread> workers;
+    workers.reserve(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+      jobs[i].target = targets[i];
+      workers.emplace_back([&opts, &job = jobs[i]] {
+        if (opts.gitStatus)
+          job.gitOk = get_git_status(job.target, job.repoRoot, job.fileStatus, job.dirStatus,
+                                     job.branches, opts.useCache);
+        job.scan = scan_tree(job.target, opts);
+      });
+    }
+    for (auto &worker : workers)
+      worker.join();
+
+    OutputWriter out;
+    for (RootJob &job : jobs) {
+      if (opts.gitStatus && !job.gitOk)
+        std::cerr << "Not a git repository (or any parent): " << job.target
+                  << ". Ignoring --git.\n";
+
+      std::optional<GitignoreMatcher> gitignore;
+      if (job.gitOk)
+        gitignore.emplace(job.repoRoot);
+      const std::string rootKey = rootKeyFor(job.gitOk, job.target, job.repoRoot);
+
+      if (opts.format != OutputFormat::Tree) {
+        print_json(job.scan.root, opts, out, job.gitOk ? &job.fileStatus : nullptr,
+                   job.gitOk ? &job.dirStatus : nullptr, gitignore ? &*gitignore : nullptr,
+                   rootKey);
+        continue;
+      }
+
+      if (job.gitOk && !job.branches.empty()) {
+        out.write("Branches: ");
+        for (size_t i = 0; i < job.branches.size(); ++i) {
+          if (i)
+            out.write(", ");
+          out.write(job.branches[i]);
+        }
+        out.write('\n');
+      }
+
+      out.colored(Color::Blue, job.target.string(), opts.useColor).write('\n');
+      if (opts.topN > 0)
+        print_top(job.scan.root, opts, out);
+      else
+        print_tree(job.scan.root, opts, out, job.gitOk ? &job.fileStatus : nullptr,
+                   job.gitOk ? &job.dirStatus : nullptr, gitignore ? &*gitignore : nullptr,
+                   rootKey);
+
+      if (opts.showStats) {
+        std::ostringstream ss;
+        ss << "Files: " << job.scan.totalFiles << ", Lines: " << job.scan.totalLines;
+        out.colored(Color::Gray, ss.str(), opts.useColor).write('\n');
       }
     }
+    out.flush();
+    if (opts.profile)
+      prof::report(std::cerr);
+    return 0;
+  }
+
+  if (opts.watch) {
+    OutputWriter watchOut;
+    return run_watch(target, opts, watchOut);
   }
 
   fs::path repo_root;
@@ -113,36 +397,164 @@ int main(int argc, char *argv[]) {
   std::unordered_map<std::string, char> dirStatus;
   std::vector<std::string> branches;
   bool gitOk = false;
+
+  // Git collection runs on its own thread so the subprocess chain overlaps
+  // the scan instead of serializing in front of it; join_git() must be
+  // called before the maps are read.
+  std::thread gitThread;
   if (opts.gitStatus) {
-    gitOk = get_git_status(target, repo_root, fileStatus, dirStatus, branches);
-    if (!gitOk)
+    gitThread = std::thread([&] {
+      gitOk = get_git_status(target, repo_root, fileStatus, dirStatus, branches, opts.useCache);
+    });
+  }
+
+  // Ignored entries are resolved in-process against .gitignore files rather
+  // than asking `git status --ignored` to enumerate them all up front.
+  std::optional<GitignoreMatcher> gitignore;
+
+  auto join_git = [&] {
+    if (gitThread.joinable())
+      gitThread.join();
+    if (opts.gitStatus && !gitOk)
       std::cerr << "Not a git repository (or any parent). Ignoring --git.\n";
-    else if (!branches.empty()) {
-      std::cout << "Branches: ";
-      for (size_t i = 0; i < branches.size(); ++i) {
-        if (i)
-          std::cout << ", ";
-        std::cout << branches[i];
-      }
-      std::cout << "\n";
+    if (gitOk && !gitignore)
+      gitignore.emplace(repo_root);
+  };
+
+  // --du and --stats need whole-subtree aggregates, so they scan into the
+  // in-memory tree; everything else streams one directory at a time with
+  // bounded memory. --save also needs the full tree to serialize.
+  const bool needAggregates = opts.diskUsage || opts.showStats || !savePath.empty();
+
+  // --load renders a previously saved snapshot instead of walking the
+  // filesystem; node names point straight into the mapping.
+  SnapshotMapping snapMapping;
+  std::optional<ScanResult> loaded;
+  if (!loadPath.empty()) {
+    loaded.emplace();
+    if (!load_snapshot(loadPath, opts, *loaded, snapMapping)) {
+      std::cerr << "Cannot load snapshot '" << loadPath << "'.\n";
+      return 1;
     }
+    target = fs::path(std::string(loaded->root.path));
   }
 
-  std::unordered_map<std::string, uintmax_t> dirSizes;
-  if (opts.diskUsage)
-    compute_dir_size(target, opts, dirSizes);
+  OutputWriter out;
 
-  std::cout << color_blue(target.string(), opts.useColor) << "\n";
-  print_tree(target, opts, dirSizes, gitOk ? repo_root : fs::path(), gitOk ? &fileStatus : nullptr,
-             gitOk ? &dirStatus : nullptr);
+  if (opts.format != OutputFormat::Tree) {
+    // Machine-readable modes: records only, no banner lines.
+    if (loaded) {
+      join_git();
+      print_json(loaded->root, opts, out, gitOk ? &fileStatus : nullptr,
+                 gitOk ? &dirStatus : nullptr, gitignore ? &*gitignore : nullptr,
+                 rootKeyFor(gitOk, target, repo_root));
+    } else if (needAggregates) {
+      const ScanResult scan = scan_tree(target, opts);
+      if (!savePath.empty() && !save_snapshot(savePath, scan))
+        std::cerr << "Warning: Cannot write snapshot '" << savePath << "'.\n";
+      join_git();
+      print_json(scan.root, opts, out, gitOk ? &fileStatus : nullptr, gitOk ? &dirStatus : nullptr,
+                 gitignore ? &*gitignore : nullptr, rootKeyFor(gitOk, target, repo_root));
+    } else {
+      join_git();
+      stream_json(target, opts, out, gitOk ? &fileStatus : nullptr, gitOk ? &dirStatus : nullptr,
+                  gitignore ? &*gitignore : nullptr, rootKeyFor(gitOk, target, repo_root));
+    }
+    out.flush();
+    if (opts.profile)
+      prof::report(std::cerr);
+    return 0;
+  }
 
-  if (opts.showStats) {
-    uintmax_t files = 0, lines = 0;
-    compute_project_stats(target, opts, files, lines);
-    std::ostringstream ss;
-    ss << "Files: " << files << ", Lines: " << lines;
-    std::cout << color_gray(ss.str(), opts.useColor) << "\n";
+  // The walk needs no git data, so the aggregate scan (or the --fast-first
+  // background scan) starts before the git thread is joined — the
+  // subprocess chain overlaps the walk instead of serializing in front of
+  // it. The maps are read only once printing begins.
+  const bool fastFirstMode = !loaded && needAggregates && opts.fastFirst && opts.topN == 0;
+  std::optional<ScanResult> scan;
+  std::thread scanThread;
+  if (!loaded && needAggregates) {
+    scan.emplace();
+    if (fastFirstMode)
+      scanThread = std::thread([&] { *scan = scan_tree(target, opts); });
+    else
+      *scan = scan_tree(target, opts);
+  }
+
+  join_git();
+
+  if (gitOk && !branches.empty()) {
+    out.write("Branches: ");
+    for (size_t i = 0; i < branches.size(); ++i) {
+      if (i)
+        out.write(", ");
+      out.write(branches[i]);
+    }
+    out.write('\n');
+  }
+
+  const std::string rootKey = rootKeyFor(gitOk, target, repo_root);
+
+  out.colored(Color::Blue, target.string(), opts.useColor).write('\n');
+
+  const GitignoreMatcher *gitignorePtr = gitignore ? &*gitignore : nullptr;
+
+  if (loaded) {
+    if (opts.topN > 0)
+      print_top(loaded->root, opts, out);
+    else
+      print_tree(loaded->root, opts, out, gitOk ? &fileStatus : nullptr,
+                 gitOk ? &dirStatus : nullptr, gitignorePtr, rootKey);
+
+    if (opts.showStats) {
+      std::ostringstream ss;
+      ss << "Files: " << loaded->totalFiles << ", Lines: " << loaded->totalLines;
+      out.colored(Color::Gray, ss.str(), opts.useColor).write('\n');
+    }
+  } else if (fastFirstMode) {
+    // --fast-first: stream the structure right away while the aggregate scan
+    // runs in the background, then append the totals. Per-entry size columns
+    // are traded for first output in milliseconds instead of after the walk.
+    Options streamOpts = opts;
+    streamOpts.showSize = false;
+    stream_tree(target, streamOpts, out, gitOk ? &fileStatus : nullptr,
+                gitOk ? &dirStatus : nullptr, gitignorePtr, rootKey);
+    out.flush();
+
+    scanThread.join();
+
+    if (!savePath.empty() && !save_snapshot(savePath, *scan))
+      std::cerr << "Warning: Cannot write snapshot '" << savePath << "'.\n";
+
+    if (opts.diskUsage)
+      out.colored(Color::Gray, "Total size: " + human_size(scan->totalSize), opts.useColor)
+          .write('\n');
+    if (opts.showStats) {
+      std::ostringstream ss;
+      ss << "Files: " << scan->totalFiles << ", Lines: " << scan->totalLines;
+      out.colored(Color::Gray, ss.str(), opts.useColor).write('\n');
+    }
+  } else if (needAggregates) {
+    if (!savePath.empty() && !save_snapshot(savePath, *scan))
+      std::cerr << "Warning: Cannot write snapshot '" << savePath << "'.\n";
+    if (opts.topN > 0)
+      print_top(scan->root, opts, out);
+    else
+      print_tree(scan->root, opts, out, gitOk ? &fileStatus : nullptr,
+                 gitOk ? &dirStatus : nullptr, gitignorePtr, rootKey);
+
+    if (opts.showStats) {
+      std::ostringstream ss;
+      ss << "Files: " << scan->totalFiles << ", Lines: " << scan->totalLines;
+      out.colored(Color::Gray, ss.str(), opts.useColor).write('\n');
+    }
+  } else {
+    stream_tree(target, opts, out, gitOk ? &fileStatus : nullptr, gitOk ? &dirStatus : nullptr,
+                gitignorePtr, rootKey);
   }
 
+  out.flush();
+  if (opts.profile)
+    prof::report(std::cerr);
   return 0;
 }
\ No newline at end of file
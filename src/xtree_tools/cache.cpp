@@ -0,0 +1,125 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "xtree/cache.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace xtree {
+
+namespace {
+
+constexpr char kMagic[4] = {'X', 'T', 'C', '2'};
+
+template <typename T> void write_pod(std::ofstream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> bool read_pod(std::ifstream &in, T &value) {
+  in.read(reinterpret_cast<char *>(&value), sizeof(value));
+  return static_cast<bool>(in);
+}
+
+void write_string(std::ofstream &out, const std::string &s) {
+  write_pod(out, static_cast<uint32_t>(s.size()));
+  out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+bool read_string(std::ifstream &in, std::string &s) {
+  uint32_t len = 0;
+  if (!read_pod(in, len) || len > (1u << 24))
+    return false;
+  s.resize(len);
+  in.read(s.data(), len);
+  return static_cast<bool>(in);
+}
+
+} // namespace
+
+bool SizeCache::load(const fs::path &file) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in)
+    return true; // cold cache, not an error
+
+  char magic[4] = {};
+  in.read(magic, sizeof(magic));
+  if (!in || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+    return false;
+
+  uint64_t dirCount = 0;
+  if (!read_pod(in, dirCount))
+    return false;
+
+  std::unordered_map<std::string, DirRecord> records;
+  records.reserve(dirCount);
+
+  for (uint64_t i = 0; i < dirCount; ++i) {
+    std::string path;
+    if (!read_string(in, path))
+      return false;
+
+    DirRecord rec;
+    uint64_t fileCount = 0;
+    if (!read_pod(in, rec.mtime) || !read_pod(in, fileCount))
+      return false;
+
+    rec.fileSizes.reserve(fileCount);
+    for (uint64_t f = 0; f < fileCount; ++f) {
+      std::string name;
+      FileRecord file;
+      uint64_t size = 0;
+      if (!read_string(in, name) || !read_pod(in, size) || !read_pod(in, file.dev) ||
+          !read_pod(in, file.ino) || !read_pod(in, file.nlink))
+        return false;
+      file.size = size;
+      rec.fileSizes.emplace(std::move(name), file);
+    }
+    records.emplace(std::move(path), std::move(rec));
+  }
+
+  loaded_ = std::move(records);
+  return true;
+}
+
+bool SizeCache::save(const fs::path &file) const {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  if (!out)
+    return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  out.write(kMagic, sizeof(kMagic));
+  write_pod(out, static_cast<uint64_t>(current_.size()));
+
+  for (const auto &kv : current_) {
+    write_string(out, kv.first);
+    write_pod(out, kv.second.mtime);
+    write_pod(out, static_cast<uint64_t>(kv.second.fileSizes.size()));
+    for (const auto &fileKv : kv.second.fileSizes) {
+      write_string(out, fileKv.first);
+      write_pod(out, static_cast<uint64_t>(fileKv.second.size));
+      write_pod(out, fileKv.second.dev);
+      write_pod(out, fileKv.second.ino);
+      write_pod(out, fileKv.second.nlink);
+    }
+  }
+
+  return static_cast<bool>(out);
+}
+
+const SizeCache::DirRecord *SizeCache::find(const std::string &dirPath, int64_t mtime) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = loaded_.find(dirPath);
+  if (it == loaded_.end() || it->second.mtime != mtime)
+    return nullptr;
+  return &it->second;
+}
+
+void SizeCache::put(const std::string &dirPath, DirRecord record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_[dirPath] = std::move(record);
+}
+
+} // namespace xtree
@@ -4,14 +4,20 @@
 
 #include "xtree/git.h"
 
+#include "xtree/profile.h"
+
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include <array>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -35,6 +41,7 @@ std::string trim(const std::string &s) {
 }
 
 std::string run_command_capture(const std::vector<std::string> &args, bool merge_stderr = false) {
+  prof::ScopedTimer timer(prof::Phase::Git);
   if (args.empty())
     return {};
 
@@ -158,7 +165,7 @@ void collect_file_status(const std::string &repo_path,
   file_status.reserve(128);
 
   const std::string output =
-      run_command_capture({"git", "-C", repo_path, "status", "--porcelain=1", "--ignored"});
+      run_command_capture({"git", "-C", repo_path, "status", "--porcelain=1"});
 
   std::istringstream stream(output);
   std::string line;
@@ -170,72 +177,357 @@ void collect_file_status(const std::string &repo_path,
   }
 }
 
-void fill_last_commit_metadata(const std::string &repo_path,
-                               std::unordered_map<std::string, FileGitInfo> &file_status) {
-  for (auto &kv : file_status) {
-    if (kv.second.ignored)
-      continue;
-
-    const std::string output = run_command_capture(
-        {"git", "-C", repo_path, "log", "-1", "--format=%an|%ad", "--date=short", "--", kv.first});
-    if (output.empty())
-      continue;
+// Submodule paths declared in .gitmodules; one cheap config read, empty
+// output when the superproject has none.
+std::vector<std::string> list_submodule_paths(const std::string &repo_path) {
+  std::vector<std::string> paths;
+  const std::string output =
+      run_command_capture({"git", "-C", repo_path, "config", "--file", ".gitmodules",
+                           "--get-regexp", "^submodule\\..*\\.path$"});
 
-    const std::string meta = trim(output);
-    const size_t delimiter = meta.find('|');
-    if (delimiter == std::string::npos)
+  std::istringstream stream(output);
+  std::string line;
+  while (std::getline(stream, line)) {
+    const size_t sep = line.find(' ');
+    if (sep == std::string::npos)
       continue;
-
-    kv.second.author = meta.substr(0, delimiter);
-    kv.second.date = trim(meta.substr(delimiter + 1));
-    if (kv.second.date.size() > 10)
-      kv.second.date.resize(10);
+    std::string path = trim(line.substr(sep + 1));
+    if (!path.empty())
+      paths.push_back(std::move(path));
   }
+  return paths;
 }
 
-int status_priority(char c) {
-  switch (c) {
-  case 'M':
-    return 5;
-  case 'A':
-    return 4;
-  case 'D':
-    return 3;
-  case 'R':
-    return 2;
-  case 'C':
-    return 1;
-  case 'U':
-    return 0;
-  case 'I':
-    return -2;
-  default:
-    return -1;
+// Collects porcelain status for every initialized submodule working tree and
+// merges the entries into `file_status` under their superproject-relative
+// subpaths. Each submodule gets its own thread: the threads mostly block on
+// their git children, so with many submodules total latency stays near that
+// of the slowest single repo instead of the sum.
+void collect_submodule_status(const std::string &repo_path,
+                              std::unordered_map<std::string, FileGitInfo> &file_status) {
+  const std::vector<std::string> subs = list_submodule_paths(repo_path);
+  if (subs.empty())
+    return;
+
+  std::vector<std::unordered_map<std::string, FileGitInfo>> results(subs.size());
+  std::vector<std::thread> workers;
+  workers.reserve(subs.size());
+  for (size_t i = 0; i < subs.size(); ++i) {
+    workers.emplace_back([&, i] {
+      const fs::path subRoot = fs::path(repo_path) / subs[i];
+      std::error_code ec;
+      if (!fs::exists(subRoot / ".git", ec)) // declared but never initialized
+        return;
+      collect_file_status(subRoot.string(), results[i]);
+    });
   }
+  for (auto &worker : workers)
+    worker.join();
+
+  for (size_t i = 0; i < subs.size(); ++i)
+    for (auto &kv : results[i])
+      file_status.emplace(subs[i] + '/' + kv.first, std::move(kv.second));
 }
 
-void build_directory_status(const std::unordered_map<std::string, FileGitInfo> &file_status,
-                            std::unordered_map<std::string, char> &dir_status) {
-  dir_status.clear();
+// Streams stdout of a command line by line into `on_line`. The callback
+// returns false to stop early, in which case the pipe is closed and the
+// child is left to exit on SIGPIPE before being reaped.
+void run_command_stream(const std::vector<std::string> &args,
+                        const std::function<bool(const std::string &)> &on_line) {
+  prof::ScopedTimer timer(prof::Phase::Git);
+  if (args.empty())
+    return;
 
-  for (const auto &pair : file_status) {
-    const char status = pair.second.status;
-    std::string full_path = pair.first;
+  int pipefd[2];
+  if (pipe(pipefd) != 0)
+    return;
 
-    while (true) {
-      const size_t pos = full_path.find_last_of('/');
-      if (pos == std::string::npos)
-        full_path.clear();
-      else
-        full_path = full_path.substr(0, pos);
+  const pid_t pid = fork();
+  if (pid < 0) {
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return;
+  }
 
-      auto it = dir_status.find(full_path);
-      if (it == dir_status.end() || status_priority(status) > status_priority(it->second))
-        dir_status[full_path] = status;
+  if (pid == 0) {
+    dup2(pipefd[1], STDOUT_FILENO);
+    close(pipefd[0]);
+    close(pipefd[1]);
 
-      if (full_path.empty())
+    std::vector<char *> argv;
+    argv.reserve(args.size() + 1);
+    for (const auto &arg : args)
+      argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+
+  close(pipefd[1]);
+
+  std::string pending;
+  std::array<char, 4096> buffer{};
+  ssize_t bytes_read;
+  bool stopped = false;
+  while (!stopped && (bytes_read = read(pipefd[0], buffer.data(), buffer.size())) > 0) {
+    pending.append(buffer.data(), static_cast<size_t>(bytes_read));
+    size_t start = 0;
+    size_t nl;
+    while ((nl = pending.find('\n', start)) != std::string::npos) {
+      if (!on_line(pending.substr(start, nl - start))) {
+        stopped = true;
         break;
+      }
+      start = nl + 1;
     }
+    pending.erase(0, start);
+  }
+  if (!stopped && !pending.empty())
+    on_line(pending);
+
+  close(pipefd[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+}
+
+// Fills author/date for all status entries with a single streamed
+// `git log --name-only` walk instead of one `git log -1` spawn per path.
+// The newest commit touching a path wins (log emits newest first), and the
+// stream is cut short as soon as every tracked entry has metadata.
+// Untracked ('U') entries never appear in the log, and staged-new entries
+// (index status 'A', never committed) almost never do — a re-added path
+// that existed in history is the exception. Neither may hold the stream
+// open across the entire history, so only the rest count toward the early
+// stop; 'A' entries still pick up metadata opportunistically when a
+// historical match occurs.
+void fill_last_commit_metadata(const std::string &repo_path,
+                               std::unordered_map<std::string, FileGitInfo> &file_status) {
+  const auto may_stamp = [](const FileGitInfo &fi) {
+    return !fi.ignored && fi.status != 'U';
+  };
+  const auto counts_toward_stop = [&](const FileGitInfo &fi) {
+    return may_stamp(fi) && fi.x != 'A';
+  };
+
+  size_t remaining = 0;
+  for (const auto &kv : file_status)
+    if (counts_toward_stop(kv.second))
+      ++remaining;
+  if (remaining == 0)
+    return;
+
+  std::string author;
+  std::string date;
+
+  run_command_stream(
+      {"git", "-C", repo_path, "log", "--name-only", "--format=\x01%an|%ad", "--date=short"},
+      [&](const std::string &line) -> bool {
+        if (!line.empty() && line.front() == '\x01') {
+          const std::string meta = trim(line.substr(1));
+          const size_t delimiter = meta.find('|');
+          if (delimiter != std::string::npos) {
+            author = meta.substr(0, delimiter);
+            date = trim(meta.substr(delimiter + 1));
+            if (date.size() > 10)
+              date.resize(10);
+          }
+          return true;
+        }
+
+        const std::string path = trim(line);
+        if (path.empty())
+          return true;
+
+        auto it = file_status.find(path);
+        if (it != file_status.end() && may_stamp(it->second) && it->second.author.empty() &&
+            it->second.date.empty()) {
+          it->second.author = author;
+          it->second.date = date;
+          if (counts_toward_stop(it->second) && --remaining == 0)
+            return false;
+        }
+        return true;
+      });
+}
+
+// --- On-disk status cache -------------------------------------------------
+//
+// A warm `xtree --git --cache` run reuses the previous run's parsed status
+// maps and branch list without spawning a single git process. The snapshot
+// is keyed by .git/HEAD content plus .git/index mtime and size, so any
+// checkout, commit, stage or unstage invalidates it. Like the size cache it
+// has a blind spot: purely-untracked changes never touch the index, so a
+// brand-new file can go unnoticed until the next index write.
+
+constexpr char kGitCacheMagic[4] = {'X', 'G', 'C', '1'};
+
+struct GitCacheKey {
+  std::string head;
+  int64_t indexMtime = 0;
+  uint64_t indexSize = 0;
+};
+
+template <typename T> void write_pod(std::ofstream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> bool read_pod(std::ifstream &in, T &value) {
+  in.read(reinterpret_cast<char *>(&value), sizeof(value));
+  return static_cast<bool>(in);
+}
+
+void write_string(std::ofstream &out, const std::string &s) {
+  write_pod(out, static_cast<uint32_t>(s.size()));
+  out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+bool read_string(std::ifstream &in, std::string &s) {
+  uint32_t len = 0;
+  if (!read_pod(in, len) || len > (1u << 24))
+    return false;
+  s.resize(len);
+  in.read(s.data(), len);
+  return static_cast<bool>(in);
+}
+
+// Resolves the actual .git directory, following the "gitdir:" redirect that
+// worktrees and submodules use in place of a real directory.
+fs::path git_dir_of(const fs::path &repo_root) {
+  const fs::path dotgit = repo_root / ".git";
+  std::error_code ec;
+  if (!fs::is_regular_file(dotgit, ec))
+    return dotgit;
+
+  std::ifstream in(dotgit);
+  std::string line;
+  if (!std::getline(in, line) || line.rfind("gitdir:", 0) != 0)
+    return {};
+  const fs::path dir = trim(line.substr(7));
+  return dir.is_absolute() ? dir : repo_root / dir;
+}
+
+bool compute_cache_key(const fs::path &repo_root, GitCacheKey &key) {
+  const fs::path gitDir = git_dir_of(repo_root);
+  if (gitDir.empty())
+    return false;
+
+  std::ifstream headIn(gitDir / "HEAD");
+  if (!headIn)
+    return false;
+  std::ostringstream head;
+  head << headIn.rdbuf();
+  key.head = head.str();
+
+  // A fresh repo has no index yet; zero key fields are fine, the HEAD
+  // content still distinguishes branches.
+  std::error_code ec;
+  const fs::path index = gitDir / "index";
+  const auto mtime = fs::last_write_time(index, ec);
+  key.indexMtime = ec ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count());
+  const uintmax_t size = fs::file_size(index, ec);
+  key.indexSize = ec ? 0 : static_cast<uint64_t>(size);
+  return true;
+}
+
+// Finds the repo root by walking up from `target` looking for .git, so a
+// cache hit avoids even the `git rev-parse` subprocess.
+bool find_repo_root_fs(const fs::path &target, fs::path &repo_root) {
+  std::error_code ec;
+  fs::path p = fs::absolute(target, ec);
+  if (ec)
+    return false;
+  p = p.lexically_normal();
+
+  while (true) {
+    if (fs::exists(p / ".git", ec)) {
+      repo_root = p;
+      return true;
+    }
+    const fs::path parent = p.parent_path();
+    if (parent == p || parent.empty())
+      return false;
+    p = parent;
+  }
+}
+
+bool load_status_cache(const fs::path &file, const GitCacheKey &key,
+                       std::unordered_map<std::string, FileGitInfo> &file_status,
+                       std::vector<std::string> &branches) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in)
+    return false;
+
+  char magic[4] = {};
+  in.read(magic, sizeof(magic));
+  if (!in || std::memcmp(magic, kGitCacheMagic, sizeof(kGitCacheMagic)) != 0)
+    return false;
+
+  std::string head;
+  int64_t indexMtime = 0;
+  uint64_t indexSize = 0;
+  if (!read_string(in, head) || !read_pod(in, indexMtime) || !read_pod(in, indexSize))
+    return false;
+  if (head != key.head || indexMtime != key.indexMtime || indexSize != key.indexSize)
+    return false;
+
+  uint32_t branchCount = 0;
+  if (!read_pod(in, branchCount) || branchCount > (1u << 16))
+    return false;
+  branches.clear();
+  branches.reserve(branchCount);
+  for (uint32_t i = 0; i < branchCount; ++i) {
+    std::string branch;
+    if (!read_string(in, branch))
+      return false;
+    branches.push_back(std::move(branch));
+  }
+
+  uint64_t entryCount = 0;
+  if (!read_pod(in, entryCount))
+    return false;
+  file_status.clear();
+  file_status.reserve(entryCount);
+  for (uint64_t i = 0; i < entryCount; ++i) {
+    std::string path;
+    FileGitInfo info;
+    uint8_t ignored = 0;
+    if (!read_string(in, path) || !read_pod(in, info.x) || !read_pod(in, info.y) ||
+        !read_pod(in, info.status) || !read_pod(in, ignored) || !read_string(in, info.author) ||
+        !read_string(in, info.date))
+      return false;
+    info.ignored = ignored != 0;
+    file_status.emplace(std::move(path), std::move(info));
+  }
+
+  return true;
+}
+
+void save_status_cache(const fs::path &file, const GitCacheKey &key,
+                       const std::unordered_map<std::string, FileGitInfo> &file_status,
+                       const std::vector<std::string> &branches) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  if (!out)
+    return;
+
+  out.write(kGitCacheMagic, sizeof(kGitCacheMagic));
+  write_string(out, key.head);
+  write_pod(out, key.indexMtime);
+  write_pod(out, key.indexSize);
+
+  write_pod(out, static_cast<uint32_t>(branches.size()));
+  for (const auto &branch : branches)
+    write_string(out, branch);
+
+  write_pod(out, static_cast<uint64_t>(file_status.size()));
+  for (const auto &kv : file_status) {
+    write_string(out, kv.first);
+    write_pod(out, kv.second.x);
+    write_pod(out, kv.second.y);
+    write_pod(out, kv.second.status);
+    write_pod(out, static_cast<uint8_t>(kv.second.ignored ? 1 : 0));
+    write_string(out, kv.second.author);
+    write_string(out, kv.second.date);
   }
 }
 
@@ -244,17 +536,46 @@ void build_directory_status(const std::unordered_map<std::string, FileGitInfo> &
 bool get_git_status(const std::filesystem::path &target, std::filesystem::path &repo_root,
                     std::unordered_map<std::string, FileGitInfo> &fileStatus,
                     std::unordered_map<std::string, char> &dirStatus,
-                    std::vector<std::string> &branches) {
+                    std::vector<std::string> &branches, bool useCache) {
+  if (useCache) {
+    fs::path cachedRoot;
+    GitCacheKey key;
+    if (find_repo_root_fs(target, cachedRoot) && compute_cache_key(cachedRoot, key) &&
+        load_status_cache(cachedRoot / kGitStatusCacheFileName, key, fileStatus, branches)) {
+      repo_root = cachedRoot;
+      build_directory_status(fileStatus, dirStatus);
+      return true;
+    }
+  }
+
   if (!resolve_repo_root(target, repo_root))
     return false;
 
   const std::string repo_path = repo_root.string();
 
-  collect_branches(repo_path, branches);
+  // Branches, the superproject status and the submodule statuses are
+  // independent git invocations, so they run concurrently; each thread
+  // mostly blocks on its own child process.
+  std::unordered_map<std::string, FileGitInfo> submoduleStatus;
+  std::thread branchThread([&] { collect_branches(repo_path, branches); });
+  std::thread submoduleThread([&] { collect_submodule_status(repo_path, submoduleStatus); });
+
   collect_file_status(repo_path, fileStatus);
   fill_last_commit_metadata(repo_path, fileStatus);
+
+  branchThread.join();
+  submoduleThread.join();
+  for (auto &kv : submoduleStatus)
+    fileStatus.emplace(kv.first, std::move(kv.second));
+
   build_directory_status(fileStatus, dirStatus);
 
+  if (useCache) {
+    GitCacheKey key;
+    if (compute_cache_key(repo_root, key))
+      save_status_cache(repo_root / kGitStatusCacheFileName, key, fileStatus, branches);
+  }
+
   return true;
 }
 
@@ -0,0 +1,64 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+// Backend-independent pieces shared by the subprocess and libgit2 git
+// backends (git.cpp / git_libgit2.cpp); the stub build compiles neither.
+
+#include "xtree/git.h"
+
+#include <string>
+
+namespace xtree {
+
+namespace {
+
+int status_priority(char c) {
+  switch (c) {
+  case 'M':
+    return 5;
+  case 'A':
+    return 4;
+  case 'D':
+    return 3;
+  case 'R':
+    return 2;
+  case 'C':
+    return 1;
+  case 'U':
+    return 0;
+  case 'I':
+    return -2;
+  default:
+    return -1;
+  }
+}
+
+} // namespace
+
+void build_directory_status(const std::unordered_map<std::string, FileGitInfo> &file_status,
+                            std::unordered_map<std::string, char> &dir_status) {
+  dir_status.clear();
+
+  for (const auto &pair : file_status) {
+    const char status = pair.second.status;
+    std::string full_path = pair.first;
+
+    while (true) {
+      const size_t pos = full_path.find_last_of('/');
+      if (pos == std::string::npos)
+        full_path.clear();
+      else
+        full_path = full_path.substr(0, pos);
+
+      auto it = dir_status.find(full_path);
+      if (it == dir_status.end() || status_priority(status) > status_priority(it->second))
+        dir_status[full_path] = status;
+
+      if (full_path.empty())
+        break;
+    }
+  }
+}
+
+} // namespace xtree
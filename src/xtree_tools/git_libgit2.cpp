@@ -0,0 +1,239 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+// In-process --git backend built on libgit2 (cmake -DENABLE_LIBGIT2=ON).
+// HEAD, index and worktree status are read through the library, so a --git
+// run spawns no child processes and re-parses no porcelain text. The
+// on-disk status cache is a subprocess-backend optimization and is ignored
+// here: in-process collection already costs less than a cache probe.
+// Submodule working trees are not yet traversed by this backend.
+
+#include "xtree/git.h"
+
+#include <git2.h>
+
+#include <cstring>
+#include <ctime>
+#include <string>
+
+namespace xtree {
+
+namespace {
+
+// Library init is process-global and refcounted; tying it to a function
+// static makes the first get_git_status() call initialize it and process
+// exit shut it down.
+struct LibGit2Handle {
+  LibGit2Handle() { git_libgit2_init(); }
+  ~LibGit2Handle() { git_libgit2_shutdown(); }
+};
+
+char index_letter(unsigned int status) {
+  if (status & GIT_STATUS_INDEX_NEW)
+    return 'A';
+  if (status & GIT_STATUS_INDEX_MODIFIED)
+    return 'M';
+  if (status & GIT_STATUS_INDEX_DELETED)
+    return 'D';
+  if (status & GIT_STATUS_INDEX_RENAMED)
+    return 'R';
+  if (status & GIT_STATUS_INDEX_TYPECHANGE)
+    return 'T';
+  return ' ';
+}
+
+char worktree_letter(unsigned int status) {
+  if (status & GIT_STATUS_WT_MODIFIED)
+    return 'M';
+  if (status & GIT_STATUS_WT_DELETED)
+    return 'D';
+  if (status & GIT_STATUS_WT_RENAMED)
+    return 'R';
+  if (status & GIT_STATUS_WT_TYPECHANGE)
+    return 'T';
+  return ' ';
+}
+
+void collect_branches(git_repository *repo, std::vector<std::string> &branches) {
+  branches.clear();
+  branches.reserve(16);
+
+  git_branch_iterator *it = nullptr;
+  if (git_branch_iterator_new(&it, repo, GIT_BRANCH_ALL) != 0)
+    return;
+
+  git_reference *ref = nullptr;
+  git_branch_t type;
+  while (git_branch_next(&ref, &type, it) == 0) {
+    const char *name = nullptr;
+    if (git_branch_name(&name, ref) == 0 && name)
+      branches.emplace_back(name);
+    git_reference_free(ref);
+  }
+  git_branch_iterator_free(it);
+}
+
+// Port of the subprocess backend's `git log --name-only` pass: walk history
+// from HEAD and stamp each status entry with the author and date of the
+// newest commit touching its path, stopping as soon as every entry is
+// annotated. Untracked ('U') and staged-new (index 'A') entries never
+// appear in history — barring a re-added path — and are excluded from the
+// countdown so the walk can actually stop early; 'A' entries still get
+// stamped opportunistically on a historical match.
+void fill_last_commit_metadata(git_repository *repo,
+                               std::unordered_map<std::string, FileGitInfo> &file_status) {
+  const auto may_stamp = [](const FileGitInfo &fi) {
+    return !fi.ignored && fi.status != 'U';
+  };
+  const auto counts_toward_stop = [&](const FileGitInfo &fi) {
+    return may_stamp(fi) && fi.x != 'A';
+  };
+
+  size_t remaining = 0;
+  for (const auto &kv : file_status)
+    if (counts_toward_stop(kv.second))
+      ++remaining;
+  if (remaining == 0)
+    return;
+
+  git_revwalk *walk = nullptr;
+  if (git_revwalk_new(&walk, repo) != 0)
+    return;
+  git_revwalk_sorting(walk, GIT_SORT_TIME);
+  if (git_revwalk_push_head(walk) != 0) {
+    git_revwalk_free(walk);
+    return;
+  }
+
+  git_oid oid;
+  while (remaining > 0 && git_revwalk_next(&oid, walk) == 0) {
+    git_commit *commit = nullptr;
+    if (git_commit_lookup(&commit, repo, &oid) != 0)
+      continue;
+
+    const git_signature *sig = git_commit_author(commit);
+    char date[16] = "";
+    if (sig) {
+      const time_t when = static_cast<time_t>(sig->when.time);
+      struct tm tmv{};
+      if (gmtime_r(&when, &tmv))
+        std::strftime(date, sizeof(date), "%Y-%m-%d", &tmv);
+    }
+
+    git_tree *tree = nullptr;
+    git_tree *parentTree = nullptr;
+    git_commit *parent = nullptr;
+    git_diff *diff = nullptr;
+    if (git_commit_tree(&tree, commit) == 0) {
+      if (git_commit_parentcount(commit) > 0 && git_commit_parent(&parent, commit, 0) == 0)
+        git_commit_tree(&parentTree, parent);
+      if (git_diff_tree_to_tree(&diff, repo, parentTree, tree, nullptr) == 0) {
+        const size_t deltas = git_diff_num_deltas(diff);
+        for (size_t i = 0; i < deltas && remaining > 0; ++i) {
+          const git_diff_delta *delta = git_diff_get_delta(diff, i);
+          const char *path = delta->new_file.path ? delta->new_file.path : delta->old_file.path;
+          if (!path)
+            continue;
+          auto it = file_status.find(path);
+          if (it == file_status.end() || !may_stamp(it->second) ||
+              !it->second.author.empty() || !it->second.date.empty())
+            continue;
+          it->second.author = sig && sig->name ? sig->name : "";
+          it->second.date = date;
+          if (counts_toward_stop(it->second))
+            --remaining;
+        }
+      }
+    }
+    git_diff_free(diff);
+    git_tree_free(parentTree);
+    git_tree_free(tree);
+    git_commit_free(parent);
+    git_commit_free(commit);
+  }
+  git_revwalk_free(walk);
+}
+
+} // namespace
+
+bool get_git_status(const std::filesystem::path &target, std::filesystem::path &repo_root,
+                    std::unordered_map<std::string, FileGitInfo> &fileStatus,
+                    std::unordered_map<std::string, char> &dirStatus,
+                    std::vector<std::string> &branches, bool useCache) {
+  (void)useCache; // no subprocesses to skip, so nothing to cache
+
+  static LibGit2Handle handle;
+
+  git_buf discovered = GIT_BUF_INIT;
+  if (git_repository_discover(&discovered, target.string().c_str(), 0, nullptr) != 0)
+    return false;
+
+  git_repository *repo = nullptr;
+  const int openRc = git_repository_open(&repo, discovered.ptr);
+  git_buf_dispose(&discovered);
+  if (openRc != 0)
+    return false;
+
+  const char *workdir = git_repository_workdir(repo);
+  if (!workdir) { // bare repository: no worktree to annotate
+    git_repository_free(repo);
+    return false;
+  }
+  std::string root = workdir;
+  while (!root.empty() && root.back() == '/')
+    root.pop_back();
+  repo_root = std::filesystem::path(root);
+
+  git_status_options statusOpts;
+  git_status_options_init(&statusOpts, GIT_STATUS_OPTIONS_VERSION);
+  statusOpts.show = GIT_STATUS_SHOW_INDEX_AND_WORKDIR;
+  statusOpts.flags = GIT_STATUS_OPT_INCLUDE_UNTRACKED | GIT_STATUS_OPT_RECURSE_UNTRACKED_DIRS |
+                     GIT_STATUS_OPT_RENAMES_HEAD_TO_INDEX;
+
+  git_status_list *list = nullptr;
+  if (git_status_list_new(&list, repo, &statusOpts) != 0) {
+    git_repository_free(repo);
+    return false;
+  }
+
+  fileStatus.clear();
+  const size_t count = git_status_list_entrycount(list);
+  fileStatus.reserve(count);
+
+  for (size_t i = 0; i < count; ++i) {
+    const git_status_entry *entry = git_status_byindex(list, i);
+    if (!entry || (entry->status & GIT_STATUS_IGNORED))
+      continue;
+
+    const git_diff_delta *delta =
+        entry->index_to_workdir ? entry->index_to_workdir : entry->head_to_index;
+    if (!delta)
+      continue;
+    const char *path = delta->new_file.path ? delta->new_file.path : delta->old_file.path;
+    if (!path || !*path)
+      continue;
+
+    FileGitInfo info;
+    if (entry->status & GIT_STATUS_WT_NEW) {
+      info.status = 'U'; // untracked, porcelain "??"
+      info.x = ' ';
+      info.y = '?';
+    } else {
+      info.x = index_letter(entry->status);
+      info.y = worktree_letter(entry->status);
+      info.status = info.y != ' ' ? info.y : info.x;
+    }
+    fileStatus[path] = info;
+  }
+  git_status_list_free(list);
+
+  collect_branches(repo, branches);
+  fill_last_commit_metadata(repo, fileStatus);
+  build_directory_status(fileStatus, dirStatus);
+
+  git_repository_free(repo);
+  return true;
+}
+
+} // namespace xtree
@@ -9,13 +9,14 @@ namespace xtree {
 bool get_git_status(const std::filesystem::path &target, std::filesystem::path &repo_root,
                     std::unordered_map<std::string, FileGitInfo> &fileStatus,
                     std::unordered_map<std::string, char> &dirStatus,
-                    std::vector<std::string> &branches) {
+                    std::vector<std::string> &branches, bool useCache) {
 
   (void)target;
   (void)repo_root;
   (void)fileStatus;
   (void)dirStatus;
   (void)branches;
+  (void)useCache;
   return false;
 }
 
@@ -0,0 +1,161 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "xtree/gitignore.h"
+
+#include <fstream>
+
+namespace xtree {
+
+namespace {
+
+// Wildcard match over a path: '*' and '?' stop at '/', '**' crosses it.
+bool path_glob_match(std::string_view pattern, std::string_view text) {
+  if (pattern.empty())
+    return text.empty();
+
+  if (pattern.size() >= 2 && pattern[0] == '*' && pattern[1] == '*') {
+    // '**' may swallow any prefix of text, including separators.
+    std::string_view rest = pattern.substr(2);
+    if (!rest.empty() && rest[0] == '/')
+      rest.remove_prefix(1);
+    for (size_t i = 0; i <= text.size(); ++i) {
+      if (path_glob_match(rest, text.substr(i)))
+        return true;
+      if (i < text.size() && rest.empty())
+        return true; // trailing '**' matches everything
+    }
+    return false;
+  }
+
+  const char p = pattern[0];
+  if (p == '*') {
+    // Zero or more characters within the current component.
+    for (size_t i = 0; i <= text.size(); ++i) {
+      if (path_glob_match(pattern.substr(1), text.substr(i)))
+        return true;
+      if (i < text.size() && text[i] == '/')
+        break;
+    }
+    return false;
+  }
+
+  if (text.empty())
+    return false;
+
+  if (p == '?')
+    return text[0] != '/' && path_glob_match(pattern.substr(1), text.substr(1));
+
+  return p == text[0] && path_glob_match(pattern.substr(1), text.substr(1));
+}
+
+std::string_view basename_of(std::string_view path) {
+  const size_t slash = path.find_last_of('/');
+  return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+GitignoreMatcher::GitignoreMatcher(fs::path repoRoot) : root_(std::move(repoRoot)) {
+  parse_file(root_ / ".git" / "info" / "exclude", excludeRules_);
+}
+
+void GitignoreMatcher::parse_file(const fs::path &file, RuleSet &out) {
+  std::ifstream in(file);
+  if (!in)
+    return;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\r' || line.back() == '\t'))
+      line.pop_back();
+    if (line.empty() || line.front() == '#')
+      continue;
+
+    Rule rule;
+    std::string pat = line;
+
+    if (pat.front() == '!') {
+      rule.negate = true;
+      pat.erase(0, 1);
+    }
+    if (!pat.empty() && pat.back() == '/') {
+      rule.dirOnly = true;
+      pat.pop_back();
+    }
+    if (!pat.empty() && pat.front() == '/') {
+      rule.anchored = true;
+      pat.erase(0, 1);
+    } else if (pat.find('/') != std::string::npos) {
+      rule.anchored = true;
+    }
+
+    if (pat.empty())
+      continue;
+    rule.pattern = std::move(pat);
+    out.rules.push_back(std::move(rule));
+  }
+}
+
+const GitignoreMatcher::RuleSet *GitignoreMatcher::dir_rules(const std::string &relDir) const {
+  auto it = cache_.find(relDir);
+  if (it != cache_.end())
+    return &it->second;
+
+  RuleSet set;
+  fs::path dir = root_;
+  if (!relDir.empty())
+    dir /= fs::path(relDir);
+  parse_file(dir / ".gitignore", set);
+
+  return &cache_.emplace(relDir, std::move(set)).first->second;
+}
+
+bool GitignoreMatcher::is_ignored(const std::string &relPath, bool isDir) const {
+  if (relPath.empty())
+    return false;
+
+  // Rule sets along the ancestor chain, root first, with the prefix length
+  // each set's rules are relative to.
+  struct ScopedSet {
+    const RuleSet *set;
+    size_t prefixLen; // bytes of relPath to strip (incl. trailing '/')
+  };
+  std::vector<ScopedSet> sets;
+  sets.push_back({&excludeRules_, 0});
+  sets.push_back({dir_rules(""), 0});
+
+  size_t start = 0;
+  for (;;) {
+    const size_t slash = relPath.find('/', start);
+    const bool last = (slash == std::string::npos);
+    const std::string_view target(relPath.data(), last ? relPath.size() : slash);
+    const bool targetIsDir = last ? isDir : true;
+
+    // Last matching rule across all in-scope files wins.
+    int verdict = -1; // -1 unmatched, 0 included, 1 ignored
+    for (const auto &scoped : sets) {
+      const std::string_view sub = target.substr(scoped.prefixLen);
+      for (const auto &rule : scoped.set->rules) {
+        if (rule.dirOnly && !targetIsDir)
+          continue;
+        const std::string_view candidate = rule.anchored ? sub : basename_of(sub);
+        if (path_glob_match(rule.pattern, candidate))
+          verdict = rule.negate ? 0 : 1;
+      }
+    }
+
+    // An ignored directory ignores everything inside it.
+    if (verdict == 1)
+      return true;
+
+    if (last)
+      return false;
+
+    sets.push_back({dir_rules(std::string(target)), target.size() + 1});
+    start = slash + 1;
+  }
+}
+
+} // namespace xtree
@@ -0,0 +1,93 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "xtree/ignore.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace xtree {
+
+namespace {
+
+std::string to_lower(std::string_view s) {
+  std::string res(s);
+  std::transform(res.begin(), res.end(), res.begin(),
+                 [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+  return res;
+}
+
+// Iterative '*'/'?' wildcard match (no heap, no backtracking explosion).
+bool glob_match(std::string_view pattern, std::string_view text) {
+  size_t p = 0, t = 0;
+  size_t star = std::string_view::npos, mark = 0;
+
+  while (t < text.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+      ++p;
+      ++t;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      mark = t;
+    } else if (star != std::string_view::npos) {
+      p = star + 1;
+      t = ++mark;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*')
+    ++p;
+  return p == pattern.size();
+}
+
+} // namespace
+
+void IgnoreMatcher::compile(const std::vector<std::string> &patterns) {
+  names_.clear();
+  extensions_.clear();
+  globs_.clear();
+
+  for (const auto &raw : patterns) {
+    const std::string pat = to_lower(raw);
+    if (pat.empty())
+      continue;
+
+    if (pat.find('*') != std::string::npos || pat.find('?') != std::string::npos) {
+      globs_.push_back(pat);
+      continue;
+    }
+
+    names_.insert(pat);
+    if (pat.front() == '.' && pat.size() > 1)
+      extensions_.insert(pat.substr(1));
+    else
+      extensions_.insert(pat);
+  }
+}
+
+bool IgnoreMatcher::matches(std::string_view filename) const {
+  if (empty() || filename.empty())
+    return false;
+
+  const std::string lower = to_lower(filename);
+
+  if (names_.count(lower))
+    return true;
+
+  // Same extension rule as fs::path: the suffix after the last dot, unless
+  // the name is a pure dotfile like ".bashrc".
+  const size_t dot = lower.find_last_of('.');
+  if (dot != std::string::npos && dot != 0 && dot + 1 < lower.size() &&
+      extensions_.count(lower.substr(dot + 1)))
+    return true;
+
+  for (const auto &glob : globs_)
+    if (glob_match(glob, lower))
+      return true;
+
+  return false;
+}
+
+} // namespace xtree
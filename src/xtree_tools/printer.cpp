@@ -2,123 +2,517 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include "xtree/filetype.h"
 #include "xtree/printer.h"
+#include "xtree/statbatch.h"
 #include "xtree/utils.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace xtree {
 
 namespace fs = std::filesystem;
 
-void print_tree(const fs::path &path, const Options &opts,
-                const std::unordered_map<std::string, uintmax_t> &dirSizes,
-                const fs::path &repo_root,
-                const std::unordered_map<std::string, FileGitInfo> *fileStatus,
-                const std::unordered_map<std::string, char> *dirStatus, int depth,
-                std::string prefix) {
+namespace {
+
+// Extends the parent's repo-relative key with this entry's name.
+std::string extend_git_key(const std::string &gitKey, std::string_view name) {
+  if (gitKey.empty())
+    return std::string(name);
+  std::string key;
+  key.reserve(gitKey.size() + 1 + name.size());
+  key = gitKey;
+  key += '/';
+  key += name;
+  return key;
+}
+
+// Git state wins (it signals pending work); otherwise the name is colored
+// by its compile-time extension class, like modern ls replacements.
+Color file_name_color(const FileGitInfo *fi, std::string_view name) {
+  if (fi) {
+    if (fi->ignored)
+      return Color::Gray;
+    if (fi->x != ' ' && fi->x != '?')
+      return Color::Yellow;
+    if (fi->y != ' ' && fi->y != '?')
+      return Color::Red;
+  }
+  switch (classify_file_type(name)) {
+  case FileType::Source:
+    return Color::Green;
+  case FileType::Image:
+    return Color::Magenta;
+  case FileType::Archive:
+    return Color::Red;
+  case FileType::Executable:
+    return Color::Cyan;
+  case FileType::Other:
+    break;
+  }
+  return Color::None;
+}
+
+void write_git_annotations(OutputWriter &out, const Options &opts, const FileGitInfo &fi) {
+  Color statusColor = Color::Gray;
+  if (!fi.ignored) {
+    if (fi.x != ' ' && fi.x != '?')
+      statusColor = Color::Yellow;
+    else if (fi.y != ' ' && fi.y != '?')
+      statusColor = Color::Red;
+  }
+  out.annotation(statusColor, std::string_view(&fi.status, 1), opts.useColor);
+
+  if (!fi.author.empty() || !fi.date.empty()) {
+    std::string meta;
+    if (!fi.author.empty()) {
+      meta = fi.author;
+      if (!fi.date.empty())
+        meta += ", " + fi.date;
+    } else {
+      meta = fi.date;
+    }
+    out.annotation(Color::Gray, meta, opts.useColor);
+  }
+}
+
+const FileGitInfo *find_file_info(const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                                  const std::string &key) {
+  if (!fileStatus || key.empty())
+    return nullptr;
+  auto it = fileStatus->find(key);
+  return it != fileStatus->end() ? &it->second : nullptr;
+}
+
+// Recursive bodies take the prefix by reference and append/truncate in
+// place, so deep trees reuse one buffer instead of allocating a fresh
+// prefix string per directory level.
+void print_tree_impl(const ScanNode &node, const Options &opts, OutputWriter &out,
+                     const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                     const std::unordered_map<std::string, char> *dirStatus,
+                     const GitignoreMatcher *gitignore, const std::string &gitKey, int depth,
+                     std::string &prefix) {
   if (opts.maxDepth != -1 && depth > opts.maxDepth)
     return;
 
-  auto entries = get_filtered_entries(path, opts);
-  const bool hasGitInfo = fileStatus && dirStatus && !repo_root.empty();
-  const fs::path &repo_root_path = repo_root;
+  const bool hasGitInfo = fileStatus && dirStatus;
 
-  for (size_t i = 0; i < entries.size(); ++i) {
-    const auto &entry = entries[i];
-    bool isLast = (i == entries.size() - 1);
+  for (size_t i = 0; i < node.children.size(); ++i) {
+    const ScanNode &child = node.children[i];
+    bool isLast = (i == node.children.size() - 1);
 
-    std::cout << prefix;
-    std::cout << (isLast ? "└── " : "├── ");
+    out.write(prefix);
+    out.write(isLast ? "└── " : "├── ");
 
-    std::string name = entry.path().filename().string();
+    const std::string_view name = child.name;
     std::string key;
-    if (hasGitInfo) {
-      fs::path rel = fs::relative(entry.path(), repo_root_path);
-      key = normalize_path(rel.generic_string());
-      if (key == ".")
-        key.clear();
+    if (hasGitInfo)
+      key = extend_git_key(gitKey, name);
+
+    if (child.isDir) {
+      out.colored(Color::Blue, name, opts.useColor);
+
+      if (opts.diskUsage)
+        out.annotation(Color::Gray, human_size(child.size), opts.useColor);
+
+      if (hasGitInfo) {
+        auto it = dirStatus->find(key);
+        if (it != dirStatus->end())
+          out.annotation(Color::Gray, std::string_view(&it->second, 1), opts.useColor);
+        else if (gitignore && gitignore->is_ignored(key, true))
+          out.annotation(Color::Gray, "I", opts.useColor);
+      }
+      out.write('\n');
+
+      const size_t mark = prefix.size();
+      prefix += isLast ? "    " : "│   ";
+      print_tree_impl(child, opts, out, fileStatus, dirStatus, gitignore, key, depth + 1, prefix);
+      prefix.resize(mark);
+    } else {
+      const FileGitInfo *fi = find_file_info(fileStatus, key);
+      const bool ignored = !fi && gitignore && gitignore->is_ignored(key, false);
+      out.colored(ignored ? Color::Gray : file_name_color(fi, name), name, opts.useColor);
+
+      if (opts.showSize)
+        out.annotation(Color::Gray, human_size(child.size), opts.useColor);
+
+      if (hasGitInfo && fi)
+        write_git_annotations(out, opts, *fi);
+      else if (ignored)
+        out.annotation(Color::Gray, "I", opts.useColor);
+      out.write('\n');
     }
+  }
+}
 
-    if (entry.is_directory()) {
-      std::cout << color_blue(name, opts.useColor);
+void stream_tree_impl(const fs::path &path, const Options &opts, OutputWriter &out,
+                      const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                      const std::unordered_map<std::string, char> *dirStatus,
+                      const GitignoreMatcher *gitignore, const std::string &gitKey, int depth,
+                      uint64_t rootDev, StatBatcher *batcher, std::string &prefix) {
+  if (opts.maxDepth != -1 && depth > opts.maxDepth)
+    return;
 
-      if (opts.diskUsage) {
-        auto it = dirSizes.find(entry.path().string());
-        if (it != dirSizes.end())
-          std::cout << " " << color_gray("(" + human_size(it->second) + ")", opts.useColor);
+  const bool hasGitInfo = fileStatus && dirStatus;
+
+  auto entries = get_filtered_entries(path, opts);
+
+  // --size: stat the whole directory as one batch before rendering, so the
+  // per-file metadata round-trips overlap (see StatBatcher).
+  std::vector<size_t> statIdx;
+  std::vector<StatBatcher::Result> statResults;
+  if (batcher) {
+    std::vector<std::string> statPaths;
+    statIdx.assign(entries.size(), SIZE_MAX);
+    for (size_t i = 0; i < entries.size(); ++i) {
+      if (entries[i].isRegular) {
+        statIdx[i] = statPaths.size();
+        statPaths.push_back((path / entries[i].name).string());
       }
+    }
+    batcher->sizes(statPaths, statResults);
+  }
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const FilteredEntry &entry = entries[i];
+    bool isLast = (i == entries.size() - 1);
+
+    out.write(prefix);
+    out.write(isLast ? "└── " : "├── ");
+
+    const std::string &name = entry.name;
+    std::string key;
+    if (hasGitInfo)
+      key = extend_git_key(gitKey, name);
+
+    if (entry.isDir) {
+      out.colored(Color::Blue, name, opts.useColor);
 
       if (hasGitInfo) {
         auto it = dirStatus->find(key);
         if (it != dirStatus->end())
-          std::cout << " " << color_gray("(" + std::string(1, it->second) + ")", opts.useColor);
+          out.annotation(Color::Gray, std::string_view(&it->second, 1), opts.useColor);
+        else if (gitignore && gitignore->is_ignored(key, true))
+          out.annotation(Color::Gray, "I", opts.useColor);
+      }
+      out.write('\n');
+
+      // --one-file-system: mount points are listed but never entered.
+      if (rootDev != 0) {
+        const uint64_t dev = device_of(path / name);
+        if (dev != 0 && dev != rootDev)
+          continue;
       }
-      std::cout << "\n";
 
-      print_tree(entry.path(), opts, dirSizes, repo_root_path, fileStatus, dirStatus, depth + 1,
-                 prefix + (isLast ? "    " : "│   "));
+      const size_t mark = prefix.size();
+      prefix += isLast ? "    " : "│   ";
+      stream_tree_impl(path / name, opts, out, fileStatus, dirStatus, gitignore, key, depth + 1,
+                       rootDev, batcher, prefix);
+      prefix.resize(mark);
     } else {
-      if (fileStatus && !key.empty()) {
-        auto itfs = fileStatus->find(key);
-        if (itfs != fileStatus->end()) {
-          const FileGitInfo &fi = itfs->second;
-          if (fi.ignored) {
-            std::cout << color_gray(name, opts.useColor);
-          } else if (fi.x != ' ' && fi.x != '?') {
-            std::cout << color_yellow(name, opts.useColor);
-          } else if (fi.y != ' ' && fi.y != '?') {
-            std::cout << color_red(name, opts.useColor);
-          } else {
-            std::cout << color_green(name, opts.useColor);
-          }
-        } else {
-          std::cout << color_green(name, opts.useColor);
-        }
+      const FileGitInfo *fi = find_file_info(fileStatus, key);
+      const bool ignored = !fi && gitignore && gitignore->is_ignored(key, false);
+      out.colored(ignored ? Color::Gray : file_name_color(fi, name), name, opts.useColor);
+
+      if (batcher && entry.isRegular) {
+        const StatBatcher::Result &res = statResults[statIdx[i]];
+        if (res.error)
+          std::cerr << "Warning: Cannot access file '" << (path / name).string()
+                    << "': " << std::error_code(res.error, std::generic_category()).message()
+                    << "\n";
+        else
+          out.annotation(Color::Gray, human_size(res.size), opts.useColor);
+      }
+
+      if (hasGitInfo && fi)
+        write_git_annotations(out, opts, *fi);
+      else if (ignored)
+        out.annotation(Color::Gray, "I", opts.useColor);
+      out.write('\n');
+    }
+  }
+}
+
+} // namespace
+
+void print_tree(const ScanNode &node, const Options &opts, OutputWriter &out,
+                const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                const std::unordered_map<std::string, char> *dirStatus,
+                const GitignoreMatcher *gitignore, const std::string &gitKey, int depth,
+                std::string prefix) {
+  print_tree_impl(node, opts, out, fileStatus, dirStatus, gitignore, gitKey, depth, prefix);
+}
+
+void stream_tree(const fs::path &path, const Options &opts, OutputWriter &out,
+                 const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                 const std::unordered_map<std::string, char> *dirStatus,
+                 const GitignoreMatcher *gitignore, const std::string &gitKey, int depth,
+                 std::string prefix) {
+  const uint64_t rootDev = opts.oneFileSystem ? device_of(path) : 0;
+  StatBatcher batcher;
+  stream_tree_impl(path, opts, out, fileStatus, dirStatus, gitignore, gitKey, depth, rootDev,
+                   opts.showSize ? &batcher : nullptr, prefix);
+}
+
+namespace {
+
+std::string json_escape(std::string_view s) {
+  std::string res;
+  res.reserve(s.size());
+  for (char c : s) {
+    switch (c) {
+    case '"':
+      res += "\\\"";
+      break;
+    case '\\':
+      res += "\\\\";
+      break;
+    case '\n':
+      res += "\\n";
+      break;
+    case '\r':
+      res += "\\r";
+      break;
+    case '\t':
+      res += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        res += buf;
+      } else {
+        res += c;
+      }
+    }
+  }
+  return res;
+}
+
+// Emits entry records in either framing: NDJSON writes one object per line,
+// JSON wraps the same records in an array with commas.
+class JsonSink {
+public:
+  JsonSink(OutputWriter &out, bool ndjson) : out_(out), ndjson_(ndjson) {
+    if (!ndjson_)
+      out_.write("[\n");
+  }
+
+  ~JsonSink() {
+    if (!ndjson_)
+      out_.write(count_ ? "\n]\n" : "]\n");
+  }
+
+  void record(std::string_view path, bool isDir, int depth, bool haveSize, uintmax_t size,
+              char gitStatus) {
+    if (!ndjson_ && count_)
+      out_.write(",\n");
+    ++count_;
+
+    out_.write("{\"path\":\"");
+    out_.write(json_escape(path));
+    out_.write("\",\"type\":\"");
+    out_.write(isDir ? "dir" : "file");
+    out_.write("\",\"depth\":");
+    out_.write(std::to_string(depth));
+    if (haveSize) {
+      out_.write(",\"size\":");
+      out_.write(std::to_string(size));
+    }
+    if (gitStatus != '\0') {
+      out_.write(",\"git\":\"");
+      char buf[2] = {gitStatus, '\0'};
+      out_.write(json_escape(buf));
+      out_.write("\"");
+    }
+    out_.write("}");
+    if (ndjson_)
+      out_.write("\n");
+  }
+
+private:
+  OutputWriter &out_;
+  bool ndjson_;
+  size_t count_ = 0;
+};
+
+void json_walk_tree(const ScanNode &node, const Options &opts, JsonSink &sink,
+                    const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                    const std::unordered_map<std::string, char> *dirStatus,
+                    const GitignoreMatcher *gitignore, const std::string &gitKey, int depth) {
+  if (opts.maxDepth != -1 && depth > opts.maxDepth)
+    return;
+
+  const bool hasGitInfo = fileStatus && dirStatus;
+  const bool haveSize = opts.showSize || opts.diskUsage;
+
+  for (const ScanNode &child : node.children) {
+    std::string key;
+    if (hasGitInfo)
+      key = extend_git_key(gitKey, child.name);
+
+    char status = '\0';
+    if (hasGitInfo) {
+      if (child.isDir) {
+        auto it = dirStatus->find(key);
+        if (it != dirStatus->end())
+          status = it->second;
       } else {
-        std::cout << color_green(name, opts.useColor);
+        const FileGitInfo *fi = find_file_info(fileStatus, key);
+        if (fi)
+          status = fi->status;
       }
+      if (status == '\0' && gitignore && gitignore->is_ignored(key, child.isDir))
+        status = 'I';
+    }
 
-      if (opts.showSize) {
-        try {
-          auto size = entry.file_size();
-          std::cout << " " << color_gray("(" + human_size(size) + ")", opts.useColor);
-        } catch (const std::exception &e) {
-          std::cerr << "Warning: Failed to get size of '" << entry.path().string()
-                    << "': " << e.what() << "\n";
-        }
+    sink.record(child.path, child.isDir, depth + 1, haveSize, child.size, status);
+    if (child.isDir)
+      json_walk_tree(child, opts, sink, fileStatus, dirStatus, gitignore, key, depth + 1);
+  }
+}
+
+void json_walk_stream(const fs::path &path, const Options &opts, JsonSink &sink,
+                      const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                      const std::unordered_map<std::string, char> *dirStatus,
+                      const GitignoreMatcher *gitignore, const std::string &gitKey, int depth,
+                      uint64_t rootDev, StatBatcher *batcher) {
+  if (opts.maxDepth != -1 && depth > opts.maxDepth)
+    return;
+
+  const bool hasGitInfo = fileStatus && dirStatus;
+
+  const auto entries = get_filtered_entries(path, opts);
+
+  std::vector<size_t> statIdx;
+  std::vector<StatBatcher::Result> statResults;
+  if (batcher) {
+    std::vector<std::string> statPaths;
+    statIdx.assign(entries.size(), SIZE_MAX);
+    for (size_t i = 0; i < entries.size(); ++i) {
+      if (entries[i].isRegular) {
+        statIdx[i] = statPaths.size();
+        statPaths.push_back((path / entries[i].name).string());
       }
+    }
+    batcher->sizes(statPaths, statResults);
+  }
 
-      if (hasGitInfo) {
-        auto it = fileStatus->find(key);
-        if (it != fileStatus->end()) {
-          const FileGitInfo &fi = it->second;
-          std::string statusStr(1, fi.status);
-          if (fi.ignored)
-            std::cout << " " << color_gray("(" + statusStr + ")", opts.useColor);
-          else if (fi.x != ' ' && fi.x != '?')
-            std::cout << " " << color_yellow("(" + statusStr + ")", opts.useColor);
-          else if (fi.y != ' ' && fi.y != '?')
-            std::cout << " " << color_red("(" + statusStr + ")", opts.useColor);
-          else
-            std::cout << " " << color_gray("(" + statusStr + ")", opts.useColor);
-
-          if (!fi.author.empty() || !fi.date.empty()) {
-            std::string meta;
-            if (!fi.author.empty()) {
-              meta = fi.author;
-              if (!fi.date.empty())
-                meta += ", " + fi.date;
-            } else if (!fi.date.empty()) {
-              meta = fi.date;
-            }
-            if (!meta.empty())
-              std::cout << " " << color_gray("(" + meta + ")", opts.useColor);
-          }
-        }
+  for (size_t ei = 0; ei < entries.size(); ++ei) {
+    const FilteredEntry &entry = entries[ei];
+    std::string key;
+    if (hasGitInfo)
+      key = extend_git_key(gitKey, entry.name);
+
+    char status = '\0';
+    if (hasGitInfo) {
+      if (entry.isDir) {
+        auto it = dirStatus->find(key);
+        if (it != dirStatus->end())
+          status = it->second;
+      } else {
+        const FileGitInfo *fi = find_file_info(fileStatus, key);
+        if (fi)
+          status = fi->status;
       }
-      std::cout << "\n";
+      if (status == '\0' && gitignore && gitignore->is_ignored(key, entry.isDir))
+        status = 'I';
     }
+
+    uintmax_t size = 0;
+    bool haveSize = false;
+    if (batcher && entry.isRegular) {
+      const StatBatcher::Result &res = statResults[statIdx[ei]];
+      size = res.size;
+      haveSize = res.error == 0;
+    }
+
+    sink.record((path / entry.name).string(), entry.isDir, depth + 1, haveSize, size, status);
+    if (entry.isDir) {
+      if (rootDev != 0) {
+        const uint64_t dev = device_of(path / entry.name);
+        if (dev != 0 && dev != rootDev)
+          continue;
+      }
+      json_walk_stream(path / entry.name, opts, sink, fileStatus, dirStatus, gitignore, key,
+                       depth + 1, rootDev, batcher);
+    }
+  }
+}
+
+} // namespace
+
+void print_json(const ScanNode &root, const Options &opts, OutputWriter &out,
+                const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                const std::unordered_map<std::string, char> *dirStatus,
+                const GitignoreMatcher *gitignore, const std::string &rootKey) {
+  JsonSink sink(out, opts.format == OutputFormat::Ndjson);
+  sink.record(root.path, true, 0, opts.showSize || opts.diskUsage, root.size, '\0');
+  json_walk_tree(root, opts, sink, fileStatus, dirStatus, gitignore, rootKey, 0);
+}
+
+void stream_json(const fs::path &path, const Options &opts, OutputWriter &out,
+                 const std::unordered_map<std::string, FileGitInfo> *fileStatus,
+                 const std::unordered_map<std::string, char> *dirStatus,
+                 const GitignoreMatcher *gitignore, const std::string &rootKey) {
+  JsonSink sink(out, opts.format == OutputFormat::Ndjson);
+  sink.record(path.string(), true, 0, false, 0, '\0');
+  const uint64_t rootDev = opts.oneFileSystem ? device_of(path) : 0;
+  StatBatcher batcher;
+  json_walk_stream(path, opts, sink, fileStatus, dirStatus, gitignore, rootKey, 0, rootDev,
+                   opts.showSize ? &batcher : nullptr);
+}
+
+namespace {
+
+struct TopEntry {
+  uintmax_t size;
+  const ScanNode *node;
+};
+
+// Min-heap on size: the root is the smallest of the current top N, so a
+// candidate either beats it (replace) or is discarded in one compare.
+bool top_heap_cmp(const TopEntry &a, const TopEntry &b) {
+  return a.size > b.size;
+}
+
+void collect_top(const ScanNode &node, size_t limit, std::vector<TopEntry> &heap) {
+  for (const ScanNode &child : node.children) {
+    if (heap.size() < limit) {
+      heap.push_back({child.size, &child});
+      std::push_heap(heap.begin(), heap.end(), top_heap_cmp);
+    } else if (child.size > heap.front().size) {
+      std::pop_heap(heap.begin(), heap.end(), top_heap_cmp);
+      heap.back() = {child.size, &child};
+      std::push_heap(heap.begin(), heap.end(), top_heap_cmp);
+    }
+    if (child.isDir)
+      collect_top(child, limit, heap);
+  }
+}
+
+} // namespace
+
+void print_top(const ScanNode &root, const Options &opts, OutputWriter &out) {
+  std::vector<TopEntry> heap;
+  heap.reserve(static_cast<size_t>(opts.topN) + 1);
+  collect_top(root, static_cast<size_t>(opts.topN), heap);
+
+  std::sort(heap.begin(), heap.end(), [](const TopEntry &a, const TopEntry &b) {
+    if (a.size != b.size)
+      return a.size > b.size;
+    return std::string_view(a.node->path) < std::string_view(b.node->path);
+  });
+
+  for (const TopEntry &entry : heap) {
+    const std::string size = human_size(entry.size);
+    if (size.size() < 8)
+      out.write(std::string(8 - size.size(), ' '));
+    out.colored(Color::Gray, size, opts.useColor);
+    out.write("  ");
+    out.colored(entry.node->isDir ? Color::Blue : Color::None, entry.node->path, opts.useColor);
+    out.write('\n');
   }
 }
 
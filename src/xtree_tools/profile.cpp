@@ -0,0 +1,65 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "xtree/profile.h"
+
+#include <atomic>
+#include <cstdio>
+
+namespace xtree {
+namespace prof {
+
+bool enabled = false;
+
+namespace {
+
+constexpr size_t kPhaseCount = static_cast<size_t>(Phase::Count_);
+
+constexpr const char *kPhaseNames[kPhaseCount] = {
+    "list", "sort", "stat", "lines", "git", "output",
+};
+
+struct PhaseStats {
+  std::atomic<uint64_t> ns{0};
+  std::atomic<uint64_t> calls{0};
+};
+
+PhaseStats phases[kPhaseCount];
+std::atomic<uint64_t> entriesListed{0};
+std::atomic<uint64_t> bytesWritten{0};
+
+} // namespace
+
+void add(Phase phase, uint64_t ns) {
+  auto &p = phases[static_cast<size_t>(phase)];
+  p.ns.fetch_add(ns, std::memory_order_relaxed);
+  p.calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void add_entries(uint64_t n) {
+  entriesListed.fetch_add(n, std::memory_order_relaxed);
+}
+
+void add_bytes(uint64_t n) {
+  bytesWritten.fetch_add(n, std::memory_order_relaxed);
+}
+
+void report(std::ostream &out) {
+  out << "\n-- profile (times sum across threads) --\n";
+  char line[128];
+  for (size_t i = 0; i < kPhaseCount; ++i) {
+    const uint64_t calls = phases[i].calls.load(std::memory_order_relaxed);
+    if (calls == 0)
+      continue;
+    const double ms = static_cast<double>(phases[i].ns.load(std::memory_order_relaxed)) / 1e6;
+    std::snprintf(line, sizeof(line), "%-8s %10.2f ms  %10llu calls\n", kPhaseNames[i], ms,
+                  static_cast<unsigned long long>(calls));
+    out << line;
+  }
+  out << "entries listed: " << entriesListed.load(std::memory_order_relaxed) << "\n";
+  out << "bytes written:  " << bytesWritten.load(std::memory_order_relaxed) << "\n";
+}
+
+} // namespace prof
+} // namespace xtree
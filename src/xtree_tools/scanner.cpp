@@ -0,0 +1,461 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "xtree/cache.h"
+#include "xtree/profile.h"
+#include "xtree/scanner.h"
+#include "xtree/utils.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace xtree {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A NUL byte in the first block marks the file as binary (.o, .a, images);
+// counting their "lines" is meaningless and burns I/O in build trees.
+bool looks_binary(const char *data, size_t len) {
+  return memchr(data, '\0', len) != nullptr;
+}
+
+uintmax_t count_newlines(const char *data, size_t len) {
+  uintmax_t count = 0;
+  const char *p = data;
+  const char *end = data + len;
+  while (p < end && (p = static_cast<const char *>(memchr(p, '\n', end - p)))) {
+    ++count;
+    ++p;
+  }
+  return count;
+}
+
+// Block-read fallback for platforms without mmap or when mapping fails.
+uintmax_t count_lines_stream(const fs::path &p) {
+  std::ifstream in(p, std::ios::binary);
+  if (!in)
+    return 0;
+
+  char buffer[64 * 1024];
+  uintmax_t lines = 0;
+  uintmax_t total = 0;
+  bool first = true;
+  while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+    const size_t got = static_cast<size_t>(in.gcount());
+    if (first && looks_binary(buffer, std::min<size_t>(got, 8192)))
+      return 0;
+    first = false;
+    lines += count_newlines(buffer, got);
+    total += got;
+    if (!in)
+      break;
+  }
+  if (total > 0)
+    ++lines;
+  return lines;
+}
+
+uintmax_t count_lines(const fs::path &p) {
+  prof::ScopedTimer timer(prof::Phase::Lines);
+#ifdef __linux__
+  const int fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return 0;
+
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+
+  const size_t size = static_cast<size_t>(st.st_size);
+  void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return count_lines_stream(p);
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  const char *data = static_cast<const char *>(map);
+  uintmax_t lines = 0;
+  if (!looks_binary(data, std::min<size_t>(size, 8192)))
+    lines = count_newlines(data, size) + 1;
+
+  munmap(map, size);
+  return lines;
+#else
+  return count_lines_stream(p);
+#endif
+}
+
+// One stat yields the size plus the identity fields hardlink dedup needs.
+struct FileStatInfo {
+  uintmax_t size = 0;
+  uint64_t dev = 0;
+  uint64_t ino = 0;
+  uintmax_t nlink = 1;
+};
+
+bool stat_file(const char *path, FileStatInfo &out, std::error_code &ec) {
+  prof::ScopedTimer timer(prof::Phase::Stat);
+#ifdef __linux__
+  struct stat st{};
+  if (stat(path, &st) != 0) {
+    ec = std::error_code(errno, std::generic_category());
+    return false;
+  }
+  out.size = static_cast<uintmax_t>(st.st_size);
+  out.dev = static_cast<uint64_t>(st.st_dev);
+  out.ino = static_cast<uint64_t>(st.st_ino);
+  out.nlink = static_cast<uintmax_t>(st.st_nlink);
+  return true;
+#else
+  const uintmax_t sz = fs::file_size(fs::path(path), ec);
+  if (ec)
+    return false;
+  out.size = sz;
+  std::error_code lec;
+  const uintmax_t links = fs::hard_link_count(fs::path(path), lec);
+  out.nlink = lec ? 1 : links;
+  return true;
+#endif
+}
+
+// Lists one directory into `node.children` without recursing. Directory
+// children are left empty; the caller decides whether to descend inline or
+// hand them to the worker pool. When `deferredFiles` is non-null the
+// per-file stat/read work is skipped and the indices of regular children
+// still needing it are collected instead, so the caller can fan them out as
+// pipeline tasks once the children vector is stable. Cached sizes are always
+// resolved inline so the directory's cache record stays complete.
+void list_directory(const fs::path &path, const Options &opts, ScanNode &node, SizeCache *cache,
+                    std::vector<size_t> *deferredFiles, Arena &arena, uint64_t rootDev) {
+  const bool wantSize = opts.showSize || opts.diskUsage;
+
+  // With --cache, an unchanged directory mtime lets us reuse last run's
+  // file sizes instead of stat'ing every file again.
+  int64_t dirMtime = 0;
+  const SizeCache::DirRecord *cached = nullptr;
+  if (cache && wantSize) {
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(path, ec);
+    if (!ec) {
+      dirMtime = mtime.time_since_epoch().count();
+      cached = cache->find(path.string(), dirMtime);
+    }
+  }
+
+  auto entries = get_filtered_entries(path, opts);
+  node.children.reserve(entries.size());
+
+  SizeCache::DirRecord fresh;
+  fresh.mtime = dirMtime;
+
+  const std::string dirPath = path.string();
+  std::string pathBuf; // reused across entries to build the child path
+
+  for (auto &entry : entries) {
+    ScanNode child;
+    pathBuf.assign(dirPath);
+    if (pathBuf.empty() || pathBuf.back() != fs::path::preferred_separator)
+      pathBuf += fs::path::preferred_separator;
+    pathBuf += entry.name;
+    child.path = arena.store(pathBuf);
+    child.name = arena.store(entry.name);
+
+    if (entry.isDir) {
+      child.isDir = true;
+      // --one-file-system: a directory on another device stays visible but
+      // is never descended, so submounts cost one stat instead of a walk.
+      if (rootDev != 0) {
+        const uint64_t dev = device_of(fs::path(child.path.data()));
+        if (dev != 0 && dev != rootDev)
+          child.otherFs = true;
+      }
+    } else if (entry.isRegular) {
+      bool deferred = false;
+      if (wantSize) {
+        bool haveSize = false;
+        if (cached) {
+          auto it = cached->fileSizes.find(std::string(child.name));
+          if (it != cached->fileSizes.end()) {
+            child.size = it->second.size;
+            child.dev = it->second.dev;
+            child.ino = it->second.ino;
+            child.nlink = it->second.nlink;
+            haveSize = true;
+          }
+        }
+        if (!haveSize) {
+          if (deferredFiles && !cache) {
+            deferred = true;
+          } else {
+            std::error_code ec;
+            FileStatInfo info;
+            if (!stat_file(child.path.data(), info, ec)) {
+              std::cerr << "Warning: Cannot access file '" << child.path << "': " << ec.message()
+                        << "\n";
+            } else {
+              child.size = info.size;
+              child.dev = info.dev;
+              child.ino = info.ino;
+              child.nlink = info.nlink;
+            }
+          }
+        }
+        if (cache)
+          fresh.fileSizes.emplace(std::string(child.name),
+                                  SizeCache::FileRecord{child.size, child.dev, child.ino,
+                                                        static_cast<uint64_t>(child.nlink)});
+      }
+      if (opts.showStats) {
+        if (deferredFiles)
+          deferred = true;
+        else
+          child.lineCount = count_lines(fs::path(child.path.data()));
+      }
+      if (deferred)
+        deferredFiles->push_back(node.children.size());
+    }
+
+    node.children.push_back(std::move(child));
+  }
+
+  if (cache && wantSize && dirMtime != 0)
+    cache->put(path.string(), std::move(fresh));
+}
+
+// --du-shallow: directories below the displayed depth are never listed, so
+// a boundary directory's size covers only its immediate children and a
+// shallow view of a huge tree costs a shallow walk. Totals at the cutoff
+// are lower bounds, which the display depth already implies.
+bool prune_below_display(const Options &opts, int depth) {
+  return opts.duShallow && opts.maxDepth != -1 && depth > opts.maxDepth + 1;
+}
+
+void scan_recursive(const fs::path &path, const Options &opts, ScanNode &node, SizeCache *cache,
+                    Arena &arena, uint64_t rootDev, int depth) {
+  list_directory(path, opts, node, cache, nullptr, arena, rootDev);
+  for (auto &child : node.children)
+    if (child.isDir && !child.otherFs && !prune_below_display(opts, depth + 1))
+      scan_recursive(fs::path(child.path.data()), opts, child, cache, arena, rootDev, depth + 1);
+}
+
+// Performs the deferred per-file work for one node: the size stat (unless
+// --cache resolved it at listing time) and the line count.
+void process_file(ScanNode &node, const Options &opts, bool needSize) {
+  if (needSize) {
+    std::error_code ec;
+    FileStatInfo info;
+    if (!stat_file(node.path.data(), info, ec)) {
+      std::cerr << "Warning: Cannot access file '" << node.path << "': " << ec.message() << "\n";
+    } else {
+      node.size = info.size;
+      node.dev = info.dev;
+      node.ino = info.ino;
+      node.nlink = info.nlink;
+    }
+  }
+  if (opts.showStats)
+    node.lineCount = count_lines(fs::path(node.path.data()));
+}
+
+// Shared-queue worker pool driving a two-stage pipeline: directory-listing
+// tasks produce per-file tasks (stat/read/count) alongside new listing
+// tasks, so one huge directory's file work is spread across all workers
+// instead of serializing inside its listing task. Tasks never wait on each
+// other, so the pool cannot deadlock; children end up sorted by
+// list_directory() regardless of completion order, which keeps output
+// deterministic.
+class ScanPool {
+public:
+  ScanPool(const Options &opts, unsigned threads, SizeCache *cache, uint64_t rootDev)
+      : opts_(opts), cache_(cache), rootDev_(rootDev) {
+    arenas_.reserve(threads);
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+      arenas_.push_back(std::make_unique<Arena>());
+      workers_.emplace_back([this, i] { worker(*arenas_[i]); });
+    }
+  }
+
+  // Hands the per-worker arenas (which own every node's strings) to the
+  // caller after the scan completes.
+  std::vector<std::unique_ptr<Arena>> take_arenas() { return std::move(arenas_); }
+
+  void run(const fs::path &root, ScanNode &node) {
+    enqueue({&node, false, 0});
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_cv_.wait(lock, [this] { return pending_ == 0; });
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &w : workers_)
+      w.join();
+    (void)root;
+  }
+
+private:
+  struct Task {
+    ScanNode *node;
+    bool isFile; // file work item rather than a directory listing
+    int depth;   // directory depth from the root, for --du-shallow pruning
+  };
+
+  void enqueue(Task task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(task);
+      ++pending_;
+    }
+    cv_.notify_one();
+  }
+
+  void worker(Arena &arena) {
+    const bool wantSize = opts_.showSize || opts_.diskUsage;
+    const bool deferFileWork = wantSize || opts_.showStats;
+    std::vector<size_t> deferredFiles;
+
+    for (;;) {
+      Task task{};
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (stop_ && queue_.empty())
+          return;
+        task = queue_.front();
+        queue_.pop_front();
+      }
+
+      if (task.isFile) {
+        process_file(*task.node, opts_, wantSize && !cache_);
+      } else {
+        deferredFiles.clear();
+        list_directory(fs::path(task.node->path.data()), opts_, *task.node, cache_,
+                       deferFileWork ? &deferredFiles : nullptr, arena, rootDev_);
+        for (auto &child : task.node->children)
+          if (child.isDir && !child.otherFs && !prune_below_display(opts_, task.depth + 1))
+            enqueue({&child, false, task.depth + 1});
+        for (size_t idx : deferredFiles)
+          enqueue({&task.node->children[idx], true, task.depth});
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0)
+          done_cv_.notify_all();
+      }
+    }
+  }
+
+  const Options &opts_;
+  SizeCache *cache_;
+  uint64_t rootDev_ = 0;
+  std::vector<std::unique_ptr<Arena>> arenas_;
+  std::vector<std::thread> workers_;
+  std::deque<Task> queue_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable done_cv_;
+  size_t pending_ = 0;
+  bool stop_ = false;
+};
+
+// (dev,ino) identity of a file already counted towards a total.
+struct DevIno {
+  uint64_t dev;
+  uint64_t ino;
+  bool operator==(const DevIno &o) const { return dev == o.dev && ino == o.ino; }
+};
+
+struct DevInoHash {
+  size_t operator()(const DevIno &k) const {
+    return std::hash<uint64_t>()(k.ino ^ (k.dev * 0x9e3779b97f4a7c15ULL));
+  }
+};
+
+// Folds per-file data up into directory aggregates after the walk. When
+// `seen` is given (--du), a hardlinked file's bytes are attributed only to
+// its first sighting in preorder, so rsync --link-dest style snapshot
+// forests report real disk usage instead of multiplied totals. Only files
+// with more than one link ever enter the set.
+void aggregate(ScanNode &node, std::unordered_set<DevIno, DevInoHash> *seen) {
+  for (auto &child : node.children) {
+    if (child.isDir) {
+      aggregate(child, seen);
+      node.fileCount += child.fileCount;
+      node.lineCount += child.lineCount;
+      node.size += child.size;
+    } else {
+      ++node.fileCount;
+      node.lineCount += child.lineCount;
+      if (seen && child.nlink > 1 && child.ino != 0 &&
+          !seen->insert({child.dev, child.ino}).second)
+        continue; // bytes already counted at the first link
+      node.size += child.size;
+    }
+  }
+}
+
+} // namespace
+
+ScanResult scan_tree(const fs::path &root, const Options &opts) {
+  ScanResult result;
+  auto rootArena = std::make_unique<Arena>();
+  result.root.name = rootArena->store(root.filename().string());
+  result.root.path = rootArena->store(root.string());
+  result.root.isDir = true;
+
+  SizeCache cache;
+  SizeCache *cachePtr = nullptr;
+  const fs::path cacheFile = root / kSizeCacheFileName;
+  if (opts.useCache && (opts.showSize || opts.diskUsage)) {
+    if (!cache.load(cacheFile))
+      std::cerr << "Warning: Ignoring unreadable size cache: " << cacheFile << "\n";
+    cachePtr = &cache;
+  }
+
+  const uint64_t rootDev = opts.oneFileSystem ? device_of(root) : 0;
+
+  unsigned threads = opts.threads >= 0 ? static_cast<unsigned>(opts.threads) : 1;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  if (threads <= 1) {
+    scan_recursive(root, opts, result.root, cachePtr, *rootArena, rootDev, 0);
+  } else {
+    ScanPool pool(opts, threads, cachePtr, rootDev);
+    pool.run(root, result.root);
+    result.arenas = pool.take_arenas();
+  }
+  result.arenas.push_back(std::move(rootArena));
+
+  if (cachePtr && !cache.save(cacheFile))
+    std::cerr << "Warning: Cannot write size cache: " << cacheFile << "\n";
+
+  std::unordered_set<DevIno, DevInoHash> seen;
+  aggregate(result.root, opts.diskUsage ? &seen : nullptr);
+  result.totalFiles = result.root.fileCount;
+  result.totalLines = result.root.lineCount;
+  result.totalSize = result.root.size;
+  return result;
+}
+
+} // namespace xtree
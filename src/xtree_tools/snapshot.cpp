@@ -0,0 +1,194 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "xtree/snapshot.h"
+#include "xtree/utils.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+
+namespace xtree {
+
+namespace {
+
+constexpr char kMagic[4] = {'X', 'T', 'S', '1'};
+
+// Per-node record, in preorder:
+//   u8  isDir
+//   u64 size, fileCount, lineCount
+//   u32 childCount
+//   u16 nameLen, name bytes, NUL
+//   u16 pathLen, path bytes, NUL
+// followed by the childCount child records. Numeric fields are read with
+// memcpy since records are not aligned.
+
+template <typename T> void write_pod(std::ofstream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> bool read_pod(const char *base, size_t size, size_t &pos, T &value) {
+  if (pos + sizeof(T) > size)
+    return false;
+  std::memcpy(&value, base + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+void write_node(std::ofstream &out, const ScanNode &node) {
+  write_pod(out, static_cast<uint8_t>(node.isDir ? 1 : 0));
+  write_pod(out, static_cast<uint64_t>(node.size));
+  write_pod(out, static_cast<uint64_t>(node.fileCount));
+  write_pod(out, static_cast<uint64_t>(node.lineCount));
+  write_pod(out, static_cast<uint32_t>(node.children.size()));
+  write_pod(out, static_cast<uint16_t>(node.name.size()));
+  out.write(node.name.data(), static_cast<std::streamsize>(node.name.size()));
+  out.put('\0');
+  write_pod(out, static_cast<uint16_t>(node.path.size()));
+  out.write(node.path.data(), static_cast<std::streamsize>(node.path.size()));
+  out.put('\0');
+
+  for (const ScanNode &child : node.children)
+    write_node(out, child);
+}
+
+// Reads a NUL-terminated string section as a view into the mapping.
+bool read_view(const char *base, size_t size, size_t &pos, std::string_view &view) {
+  uint16_t len = 0;
+  if (!read_pod(base, size, pos, len) || pos + len + 1 > size || base[pos + len] != '\0')
+    return false;
+  view = std::string_view(base + pos, len);
+  pos += static_cast<size_t>(len) + 1;
+  return true;
+}
+
+// Reconstructs one node and its subtree. Filtered-out children are still
+// decoded (the layout is sequential) but not attached; `keep` is false for
+// them and everything below. `filter` is false only for the root, which is
+// never subject to --all/--ignore.
+bool read_node(const char *base, size_t size, size_t &pos, const Options &opts, ScanNode &node,
+               bool keep, bool filter, bool &kept) {
+  uint8_t isDir = 0;
+  uint64_t nodeSize = 0;
+  uint64_t fileCount = 0;
+  uint64_t lineCount = 0;
+  uint32_t childCount = 0;
+  if (!read_pod(base, size, pos, isDir) || !read_pod(base, size, pos, nodeSize) ||
+      !read_pod(base, size, pos, fileCount) || !read_pod(base, size, pos, lineCount) ||
+      !read_pod(base, size, pos, childCount))
+    return false;
+  if (!read_view(base, size, pos, node.name) || !read_view(base, size, pos, node.path))
+    return false;
+
+  node.isDir = isDir != 0;
+  node.size = nodeSize;
+  node.fileCount = fileCount;
+  node.lineCount = lineCount;
+
+  kept = keep;
+  if (keep && filter && !node.name.empty()) {
+    if (!opts.showHidden && node.name.front() == '.')
+      kept = false;
+    else if (!opts.ignoreMatcher.empty() && opts.ignoreMatcher.matches(std::string(node.name)))
+      kept = false;
+  }
+
+  if (kept)
+    node.children.reserve(childCount);
+  for (uint32_t i = 0; i < childCount; ++i) {
+    ScanNode child;
+    bool childKept = false;
+    if (!read_node(base, size, pos, opts, child, kept, true, childKept))
+      return false;
+    if (childKept)
+      node.children.push_back(std::move(child));
+  }
+  return true;
+}
+
+} // namespace
+
+SnapshotMapping::~SnapshotMapping() {
+  if (!data)
+    return;
+#ifdef __linux__
+  if (mapped) {
+    munmap(const_cast<char *>(data), size);
+    return;
+  }
+#endif
+  delete[] data;
+}
+
+bool save_snapshot(const fs::path &file, const ScanResult &scan) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  if (!out)
+    return false;
+
+  out.write(kMagic, sizeof(kMagic));
+  write_node(out, scan.root);
+  return static_cast<bool>(out);
+}
+
+bool load_snapshot(const fs::path &file, const Options &opts, ScanResult &out,
+                   SnapshotMapping &mapping) {
+#ifdef __linux__
+  const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    struct stat st{};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        mapping.data = static_cast<const char *>(data);
+        mapping.size = static_cast<size_t>(st.st_size);
+        mapping.mapped = true;
+      }
+    }
+    close(fd);
+  }
+#endif
+
+  if (!mapping.data) {
+    // Portable fallback: read the whole file into a heap buffer the
+    // mapping owns; views point into it just the same.
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    if (!in)
+      return false;
+    const std::streamsize size = in.tellg();
+    if (size <= 0)
+      return false;
+    in.seekg(0);
+    char *buffer = new char[static_cast<size_t>(size)];
+    if (!in.read(buffer, size)) {
+      delete[] buffer;
+      return false;
+    }
+    mapping.data = buffer;
+    mapping.size = static_cast<size_t>(size);
+    mapping.mapped = false;
+  }
+
+  if (mapping.size < sizeof(kMagic) ||
+      std::memcmp(mapping.data, kMagic, sizeof(kMagic)) != 0)
+    return false;
+
+  size_t pos = sizeof(kMagic);
+  bool kept = false;
+  if (!read_node(mapping.data, mapping.size, pos, opts, out.root, true, false, kept))
+    return false;
+
+  out.totalFiles = out.root.fileCount;
+  out.totalLines = out.root.lineCount;
+  out.totalSize = out.root.size;
+  return true;
+}
+
+} // namespace xtree
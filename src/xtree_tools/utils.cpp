@@ -4,6 +4,16 @@
 
 #include "xtree/utils.h"
 
+#include "xtree/profile.h"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
@@ -22,6 +32,8 @@ constexpr const char *ANSI_GREEN = "\033[1;32m";
 constexpr const char *ANSI_GRAY = "\033[0;37m";
 constexpr const char *ANSI_RED = "\033[1;31m";
 constexpr const char *ANSI_YELLOW = "\033[1;33m";
+constexpr const char *ANSI_MAGENTA = "\033[1;35m";
+constexpr const char *ANSI_CYAN = "\033[1;36m";
 
 void print_help() {
   std::cout << "Usage: xtree [OPTIONS] [PATH]\n"
@@ -29,19 +41,45 @@ void print_help() {
                "\n"
                "Options:\n"
                "  --help              Show this help message\n"
-               "  --all               Show hidden files (starting with dot)\n"
-               "  --size              Show file sizes\n"
+               "  -a, --all           Show hidden files (starting with dot)\n"
+               "  -s, --size          Show file sizes\n"
                "  --no-color          Disable colored output\n"
                "  --depth N           Limit recursion depth (N levels)\n"
-               "  --ignore=\"p1, p2\"   Ignore files with given extensions or "
-               "folders with exact names (comma-separated)\n"
-               "  --git               Show Git status: M(odified), A(dded), "
+               "  --ignore=\"p1, p2\"   Ignore files with given extensions, "
+               "exact names or *?-globs (comma-separated)\n"
+               "  -g, --git           Show Git status: M(odified), A(dded), "
                "D(eleted), R(enamed), C(opied), U(ntracked)\n"
-               "  --du                Show directory sizes (total of all files "
-               "inside)\n"
-               "  --follow-links      Follow symbolic links\n"
+               "  -d, --du            Show directory sizes (total of all files "
+               "inside; hardlinked content is counted once)\n"
+               "  --du-shallow        Like --du, but stop aggregating at the "
+               "--depth cutoff: boundary directories show only their immediate "
+               "contents, so shallow views of huge trees stay fast\n"
+               "  --cache             Reuse file sizes (.xtree.cache) and git "
+               "status (.xtree.gitcache) from the previous run when unchanged\n"
+               "  -L, --follow-links  Follow symbolic links\n"
                "  --stats             Show total file and line counts\n"
+               "  --threads N         Scan with N worker threads (0 = one per "
+               "core, default 1)\n"
+               "  --fast-first        With --du/--stats: print the tree "
+               "immediately, append totals when the scan finishes\n"
+               "  --watch             Stay resident and re-render when the "
+               "tree changes (Linux/inotify)\n"
+               "  --natural-sort      Sort names case-insensitively with "
+               "numeric runs in value order (file2 before file10)\n"
+               "  -x, --one-file-system  Do not descend into directories on "
+               "other filesystems (mount points stay visible as leaves)\n"
+               "  --save FILE         Write the scanned tree to a binary "
+               "snapshot after printing\n"
+               "  --load FILE         Render from a snapshot instead of "
+               "walking the filesystem\n"
+               "  --format=FMT        Output format: tree (default), json or "
+               "ndjson (one record per entry)\n"
+               "  --top N             Print only the N largest files and "
+               "directories, largest first (implies --du)\n"
+               "  --profile           Print a per-phase timing summary to "
+               "stderr when the run finishes\n"
                "\n"
+               "Short flags combine: -asL == --all --size --follow-links.\n"
                "If PATH is omitted, current directory is used.\n"
                "\n"
                "Examples:\n"
@@ -72,6 +110,14 @@ std::string color_yellow(const std::string &s, bool color) {
   return color ? ANSI_YELLOW + s + ANSI_RESET : s;
 }
 
+std::string color_magenta(const std::string &s, bool color) {
+  return color ? ANSI_MAGENTA + s + ANSI_RESET : s;
+}
+
+std::string color_cyan(const std::string &s, bool color) {
+  return color ? ANSI_CYAN + s + ANSI_RESET : s;
+}
+
 std::string human_size(uintmax_t size) {
   if (size == 0)
     return "0B";
@@ -103,146 +149,234 @@ std::string normalize_path(const std::string &p) {
 }
 
 bool should_ignore(const fs::path &path, const Options &opts) {
-  if (opts.ignorePatterns.empty())
+  if (opts.ignoreMatcher.empty())
     return false;
-  std::string filename = path.filename().string();
-  std::transform(filename.begin(), filename.end(), filename.begin(),
-                 [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
-
-  if (path.has_extension()) {
-    std::string ext = path.extension().string();
-    if (!ext.empty() && ext[0] == '.')
-      ext = ext.substr(1);
-    std::transform(ext.begin(), ext.end(), ext.begin(),
-                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
-    for (const auto &pat : opts.ignorePatterns) {
-      if (ext == pat || (pat.size() > 1 && pat.front() == '.' && ext == pat.substr(1)))
-        return true;
+  return opts.ignoreMatcher.matches(path.filename().string());
+}
+
+namespace {
+
+// Case-folded comparison ordering digit runs by numeric value, so "file2"
+// sorts before "file10". Allocation-free: runs are compared in place, no
+// per-comparison key is built.
+bool natural_less(std::string_view a, std::string_view b) {
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    const unsigned char ca = static_cast<unsigned char>(a[i]);
+    const unsigned char cb = static_cast<unsigned char>(b[j]);
+
+    if (std::isdigit(ca) && std::isdigit(cb)) {
+      // Skip leading zeros, then compare runs: more significant digits win,
+      // equal-length runs compare lexicographically (== numerically).
+      size_t za = i;
+      while (za < a.size() && a[za] == '0')
+        ++za;
+      size_t zb = j;
+      while (zb < b.size() && b[zb] == '0')
+        ++zb;
+      size_t ea = za;
+      while (ea < a.size() && std::isdigit(static_cast<unsigned char>(a[ea])))
+        ++ea;
+      size_t eb = zb;
+      while (eb < b.size() && std::isdigit(static_cast<unsigned char>(b[eb])))
+        ++eb;
+      if (ea - za != eb - zb)
+        return ea - za < eb - zb;
+      const int cmp = a.compare(za, ea - za, b, zb, eb - zb);
+      if (cmp != 0)
+        return cmp < 0;
+      if (za - i != zb - j)
+        return za - i < zb - j; // equal value: fewer leading zeros first
+      i = ea;
+      j = eb;
+      continue;
     }
+
+    const unsigned char fa = static_cast<unsigned char>(std::tolower(ca));
+    const unsigned char fb = static_cast<unsigned char>(std::tolower(cb));
+    if (fa != fb)
+      return fa < fb;
+    ++i;
+    ++j;
   }
-  for (const auto &pat : opts.ignorePatterns) {
-    if (filename == pat)
-      return true;
-  }
-  return false;
+
+  if (a.size() - i != b.size() - j)
+    return a.size() - i < b.size() - j;
+  return a < b; // equal ignoring case: raw bytes keep the order total
 }
 
-std::vector<fs::directory_entry> get_filtered_entries(const fs::path &path, const Options &opts) {
-  std::vector<fs::directory_entry> entries;
-  entries.reserve(64);
+void sort_entries(std::vector<FilteredEntry> &entries, bool natural) {
+  std::sort(entries.begin(), entries.end(),
+            [natural](const FilteredEntry &a, const FilteredEntry &b) {
+              if (a.isDir != b.isDir)
+                return a.isDir > b.isDir;
+              return natural ? natural_less(a.name, b.name) : a.name < b.name;
+            });
+}
 
+#ifdef __linux__
+// Raw getdents64 reader: classifies entries from d_type without a stat per
+// entry. Returns false when the directory cannot be read this way (open
+// failure or a filesystem reporting DT_UNKNOWN), letting the caller fall
+// back to the portable iterator.
+bool list_dir_getdents(const fs::path &path, const Options &opts,
+                       std::vector<FilteredEntry> &entries) {
+  const int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  struct linux_dirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[256]; // NAME_MAX + NUL; actual record stride is d_reclen
+  };
+
+  alignas(linux_dirent64) char buffer[32 * 1024];
+  bool ok = true;
+
+  for (;;) {
+    const ssize_t nread = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+    if (nread < 0) {
+      ok = false;
+      break;
+    }
+    if (nread == 0)
+      break;
+
+    for (ssize_t pos = 0; pos < nread;) {
+      const auto *d = reinterpret_cast<const linux_dirent64 *>(buffer + pos);
+      pos += d->d_reclen;
+
+      const char *name = d->d_name;
+      if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        continue;
+      if (!opts.showHidden && name[0] == '.')
+        continue;
+
+      FilteredEntry entry;
+      entry.name = name;
+
+      switch (d->d_type) {
+      case DT_DIR:
+        entry.isDir = true;
+        break;
+      case DT_REG:
+        entry.isRegular = true;
+        break;
+      case DT_LNK: {
+        if (!opts.followSymlinks)
+          continue;
+        std::error_code ec;
+        const auto st = fs::status(path / entry.name, ec);
+        if (ec)
+          continue;
+        entry.isDir = fs::is_directory(st);
+        entry.isRegular = fs::is_regular_file(st);
+        break;
+      }
+      case DT_UNKNOWN: {
+        // Filesystem doesn't fill d_type; classify this one entry via lstat.
+        std::error_code ec;
+        const auto st = fs::symlink_status(path / entry.name, ec);
+        if (ec)
+          continue;
+        if (fs::is_symlink(st)) {
+          if (!opts.followSymlinks)
+            continue;
+          const auto target = fs::status(path / entry.name, ec);
+          if (ec)
+            continue;
+          entry.isDir = fs::is_directory(target);
+          entry.isRegular = fs::is_regular_file(target);
+        } else {
+          entry.isDir = fs::is_directory(st);
+          entry.isRegular = fs::is_regular_file(st);
+        }
+        break;
+      }
+      default:
+        break; // sockets, fifos, devices: listed but neither dir nor regular
+      }
+
+      if (!opts.ignoreMatcher.empty() && opts.ignoreMatcher.matches(entry.name))
+        continue;
+
+      entries.push_back(std::move(entry));
+    }
+  }
+
+  close(fd);
+  if (!ok)
+    entries.clear();
+  return ok;
+}
+#endif // __linux__
+
+void list_dir_portable(const fs::path &path, const Options &opts,
+                       std::vector<FilteredEntry> &entries) {
   try {
     for (const auto &entry :
          fs::directory_iterator(path, fs::directory_options::skip_permission_denied)) {
       const auto &p = entry.path();
-      const std::string fname = p.filename().string();
+      FilteredEntry fe;
+      fe.name = p.filename().string();
 
-      if (!opts.showHidden && !fname.empty() && fname.front() == '.')
+      if (!opts.showHidden && !fe.name.empty() && fe.name.front() == '.')
         continue;
 
-      if (should_ignore(p, opts))
+      if (!opts.ignoreMatcher.empty() && opts.ignoreMatcher.matches(fe.name))
         continue;
 
       if (!opts.followSymlinks && entry.is_symlink())
         continue;
 
-      entries.emplace_back(entry);
+      fe.isDir = entry.is_directory();
+      fe.isRegular = entry.is_regular_file();
+      entries.push_back(std::move(fe));
     }
   } catch (const std::exception &e) {
     std::cerr << "Warning: Cannot read directory: " << path << " (" << e.what() << ")\n";
   }
-
-  std::sort(entries.begin(), entries.end(),
-            [](const fs::directory_entry &a, const fs::directory_entry &b) {
-              const bool a_dir = a.is_directory();
-              const bool b_dir = b.is_directory();
-
-              if (a_dir != b_dir)
-                return a_dir > b_dir;
-
-              return a.path().filename() < b.path().filename();
-            });
-
-  return entries;
 }
 
-uintmax_t compute_dir_size(const fs::path &root, const Options &opts,
-                           std::unordered_map<std::string, uintmax_t> &dirSizes) {
-  uintmax_t total = 0;
+} // namespace
 
-  std::error_code ec;
-  const auto options = fs::directory_options::skip_permission_denied |
-                       (opts.followSymlinks ? fs::directory_options::follow_directory_symlink
-                                            : fs::directory_options::none);
+std::vector<FilteredEntry> get_filtered_entries(const fs::path &path, const Options &opts) {
+  std::vector<FilteredEntry> entries;
+  entries.reserve(64);
 
-  fs::recursive_directory_iterator it(root, options, ec), end;
-  if (ec) {
-    std::cerr << "Warning: Cannot read directory: " << root << " (" << ec.message() << ")\n";
-    return 0;
+  {
+    prof::ScopedTimer timer(prof::Phase::List);
+#ifdef __linux__
+    if (!list_dir_getdents(path, opts, entries))
+      list_dir_portable(path, opts, entries);
+#else
+    list_dir_portable(path, opts, entries);
+#endif
   }
+  if (prof::enabled)
+    prof::add_entries(entries.size());
 
-  for (; it != end; it.increment(ec)) {
-    if (ec) {
-      std::cerr << "Warning: Cannot access entry: " << it->path().string() << " (" << ec.message()
-                << ")\n";
-      ec.clear();
-      continue;
-    }
-
-    const fs::path p = it->path();
-    const std::string fname = p.filename().string();
-
-    if (!opts.showHidden && !fname.empty() && fname.front() == '.') {
-      if (it->is_directory(ec) && !ec)
-        it.disable_recursion_pending();
-      ec.clear();
-      continue;
-    }
-
-    if (!opts.followSymlinks && it->is_symlink(ec) && !ec) {
-      if (it->is_directory(ec) && !ec)
-        it.disable_recursion_pending();
-      ec.clear();
-      continue;
-    }
-
-    if (it->is_directory(ec)) {
-      if (ec) {
-        ec.clear();
-      } else if (should_ignore(p, opts)) {
-        it.disable_recursion_pending();
-      }
-      continue;
-    }
-
-    if (!it->is_regular_file(ec) || ec) {
-      ec.clear();
-      continue;
-    }
-
-    if (should_ignore(p, opts)) {
-      continue;
-    }
-
-    const uintmax_t sz = it->file_size(ec);
-    if (ec) {
-      std::cerr << "Warning: Cannot access file '" << p.string() << "': " << ec.message() << "\n";
-      ec.clear();
-      continue;
-    }
-
-    total += sz;
-    fs::path cur = p.parent_path();
-    while (!cur.empty() && cur != cur.root_path()) {
-      dirSizes[cur.string()] += sz;
-      if (cur == root)
-        break;
-      cur = cur.parent_path();
-    }
+  {
+    prof::ScopedTimer timer(prof::Phase::Sort);
+    sort_entries(entries, opts.naturalSort);
   }
+  return entries;
+}
 
-  dirSizes.emplace(root.string(), 0);
-  return total;
+uint64_t device_of(const fs::path &p) {
+#ifdef __linux__
+  struct stat st{};
+  if (stat(p.c_str(), &st) != 0)
+    return 0;
+  return static_cast<uint64_t>(st.st_dev);
+#else
+  (void)p;
+  return 0;
+#endif
 }
 
 void parse_ignore_patterns(const std::string &input, std::vector<std::string> &patterns) {
@@ -267,39 +401,4 @@ void parse_ignore_patterns(const std::string &input, std::vector<std::string> &p
   }
 }
 
-void compute_project_stats(const fs::path &path, const Options &opts, uintmax_t &fileCount,
-                           uintmax_t &lineCount) {
-  fileCount = 0;
-  lineCount = 0;
-  auto entries = get_filtered_entries(path, opts);
-
-  for (const auto &entry : entries) {
-    try {
-      if (entry.is_directory() && (!fs::is_symlink(entry.path()) || opts.followSymlinks)) {
-        uintmax_t fc = 0, lc = 0;
-        compute_project_stats(entry.path(), opts, fc, lc);
-        fileCount += fc;
-        lineCount += lc;
-      } else if (entry.is_regular_file()) {
-        ++fileCount;
-        std::ifstream in(entry.path());
-        if (in) {
-          const auto begin = std::istreambuf_iterator<char>(in);
-          const auto end = std::istreambuf_iterator<char>();
-          const uintmax_t newlines = std::count(begin, end, '\n');
-          in.clear();
-          in.seekg(0, std::ios::end);
-          const auto size = in.tellg();
-          lineCount += newlines;
-          if (size > 0)
-            ++lineCount;
-        }
-      }
-    } catch (const std::exception &e) {
-      std::cerr << "Warning: Failed to process '" << entry.path().string() << "': " << e.what()
-                << "\n";
-    }
-  }
-}
-
 } // namespace xtree
@@ -0,0 +1,309 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "xtree/watcher.h"
+
+#include "xtree/cache.h"
+#include "xtree/git.h"
+#include "xtree/gitignore.h"
+#include "xtree/printer.h"
+#include "xtree/scanner.h"
+#include "xtree/utils.h"
+
+#include <iostream>
+
+#ifdef __linux__
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace xtree {
+
+namespace {
+
+constexpr uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY |
+                                IN_ATTRIB | IN_DELETE_SELF | IN_ONLYDIR;
+
+// wd <-> directory path bookkeeping for the inotify descriptor.
+struct WatchMap {
+  std::unordered_map<int, std::string> wdToPath;
+  std::unordered_map<std::string, int> pathToWd;
+
+  void add(int fd, const std::string &path) {
+    if (pathToWd.count(path))
+      return;
+    const int wd = inotify_add_watch(fd, path.c_str(), kWatchMask);
+    if (wd < 0)
+      return;
+    wdToPath[wd] = path;
+    pathToWd[path] = wd;
+  }
+
+  void forget(int wd) {
+    auto it = wdToPath.find(wd);
+    if (it == wdToPath.end())
+      return;
+    pathToWd.erase(it->second);
+    wdToPath.erase(it);
+  }
+};
+
+void watch_subtree(int fd, const ScanNode &node, WatchMap &watches) {
+  watches.add(fd, std::string(node.path));
+  for (const auto &child : node.children)
+    if (child.isDir)
+      watch_subtree(fd, child, watches);
+}
+
+// Finds the resident directory node for `path` by descending the prefix
+// chain from the root; null when the path left the tree (e.g. deleted).
+ScanNode *find_dir(ScanNode &node, std::string_view path) {
+  if (node.path == path)
+    return &node;
+  for (auto &child : node.children) {
+    if (!child.isDir)
+      continue;
+    const std::string_view cp = child.path;
+    if (path.size() >= cp.size() && path.compare(0, cp.size(), cp) == 0 &&
+        (path.size() == cp.size() || path[cp.size()] == '/'))
+      return find_dir(child, path);
+  }
+  return nullptr;
+}
+
+// (dev,ino) identity for hardlink dedup, mirroring the scanner's.
+struct DevIno {
+  uint64_t dev;
+  uint64_t ino;
+  bool operator==(const DevIno &o) const { return dev == o.dev && ino == o.ino; }
+};
+
+struct DevInoHash {
+  size_t operator()(const DevIno &k) const {
+    return std::hash<uint64_t>()(k.ino ^ (k.dev * 0x9e3779b97f4a7c15ULL));
+  }
+};
+
+// Recomputes directory aggregates bottom-up after a splice. Mirrors the
+// scanner's aggregate() — including counting a hardlinked file's bytes only
+// at its first preorder sighting when `seen` is given (--du), so totals
+// stay identical across re-renders — but resets totals first so it can run
+// repeatedly.
+void re_aggregate(ScanNode &node, std::unordered_set<DevIno, DevInoHash> *seen) {
+  node.size = 0;
+  node.fileCount = 0;
+  node.lineCount = 0;
+  for (auto &child : node.children) {
+    if (child.isDir) {
+      re_aggregate(child, seen);
+      node.fileCount += child.fileCount;
+      node.lineCount += child.lineCount;
+      node.size += child.size;
+    } else {
+      ++node.fileCount;
+      node.lineCount += child.lineCount;
+      if (seen && child.nlink > 1 && child.ino != 0 &&
+          !seen->insert({child.dev, child.ino}).second)
+        continue; // bytes already counted at the first link
+      node.size += child.size;
+    }
+  }
+}
+
+// Repo-relative key of the watched root, seed for the incremental git keys.
+std::string root_key_for(bool gitOk, const fs::path &target, const fs::path &repo_root) {
+  if (!gitOk)
+    return {};
+  std::string key = normalize_path(fs::relative(target, repo_root).generic_string());
+  if (key == ".")
+    key.clear();
+  return key;
+}
+
+void render(const ScanResult &scan, const fs::path &target, const Options &opts,
+            OutputWriter &out) {
+  fs::path repo_root;
+  std::unordered_map<std::string, FileGitInfo> fileStatus;
+  std::unordered_map<std::string, char> dirStatus;
+  std::vector<std::string> branches;
+  bool gitOk = false;
+  if (opts.gitStatus)
+    gitOk = get_git_status(target, repo_root, fileStatus, dirStatus, branches, opts.useCache);
+
+  std::optional<GitignoreMatcher> gitignore;
+  if (gitOk)
+    gitignore.emplace(repo_root);
+
+  out.write("\033[2J\033[H"); // clear screen, home cursor
+
+  if (gitOk && !branches.empty()) {
+    out.write("Branches: ");
+    for (size_t i = 0; i < branches.size(); ++i) {
+      if (i)
+        out.write(", ");
+      out.write(branches[i]);
+    }
+    out.write('\n');
+  }
+
+  out.colored(Color::Blue, target.string(), opts.useColor).write('\n');
+  print_tree(scan.root, opts, out, gitOk ? &fileStatus : nullptr, gitOk ? &dirStatus : nullptr,
+             gitignore ? &*gitignore : nullptr, root_key_for(gitOk, target, repo_root));
+
+  if (opts.showStats) {
+    std::ostringstream ss;
+    ss << "Files: " << scan.root.fileCount << ", Lines: " << scan.root.lineCount;
+    out.colored(Color::Gray, ss.str(), opts.useColor).write('\n');
+  }
+
+  out.flush();
+}
+
+// Re-lists one directory and splices the fresh subtree into the resident
+// node, taking ownership of the sub-scan's arenas. Stale names from the
+// replaced subtree stay in their arenas until exit; memory therefore grows
+// with total churn, not with re-render count. Sub-scans never touch the
+// size cache: a cache write into the directory just re-listed would raise
+// an event there and schedule the next re-render indefinitely, and would
+// litter every respliced subdirectory with a cache file no top-level run
+// ever reads.
+void resplice(ScanResult &scan, ScanNode &node, const Options &opts, int fd, WatchMap &watches) {
+  Options subOpts = opts;
+  subOpts.useCache = false;
+  ScanResult sub = scan_tree(fs::path(std::string(node.path)), subOpts);
+  node.children = std::move(sub.root.children);
+  for (auto &arena : sub.arenas)
+    scan.arenas.push_back(std::move(arena));
+  for (const auto &child : node.children)
+    if (child.isDir)
+      watch_subtree(fd, child, watches);
+}
+
+} // namespace
+
+int run_watch(const fs::path &target, const Options &opts, OutputWriter &out) {
+  if (opts.format != OutputFormat::Tree) {
+    std::cerr << "--watch supports only the tree format.\n";
+    return 2;
+  }
+
+  const int fd = inotify_init1(IN_CLOEXEC);
+  if (fd < 0) {
+    std::cerr << "Cannot initialize inotify: " << std::strerror(errno) << "\n";
+    return 1;
+  }
+
+  ScanResult scan = scan_tree(target, opts);
+
+  WatchMap watches;
+  watch_subtree(fd, scan.root, watches);
+
+  render(scan, target, opts, out);
+
+  std::vector<std::string> dirty;
+  alignas(inotify_event) char buffer[16 * 1024];
+
+  for (;;) {
+    // Block until the first event, then keep draining with a short timeout
+    // so a burst (e.g. a build writing many files) coalesces into one
+    // re-list and one re-render.
+    struct pollfd pfd = {fd, POLLIN, 0};
+    const int timeout = dirty.empty() ? -1 : 100;
+    const int ready = poll(&pfd, 1, timeout);
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (ready > 0) {
+      const ssize_t len = read(fd, buffer, sizeof(buffer));
+      if (len <= 0)
+        break;
+      for (ssize_t pos = 0; pos < len;) {
+        const auto *event = reinterpret_cast<const inotify_event *>(buffer + pos);
+        pos += sizeof(inotify_event) + event->len;
+
+        if (event->mask & IN_IGNORED) {
+          watches.forget(event->wd);
+          continue;
+        }
+        // xtree's own cache writes (the git status cache is refreshed by
+        // every render) must not dirty the tree, or each re-render would
+        // schedule the next one.
+        if (event->len > 0 && (std::strcmp(event->name, kSizeCacheFileName) == 0 ||
+                               std::strcmp(event->name, kGitStatusCacheFileName) == 0))
+          continue;
+        auto it = watches.wdToPath.find(event->wd);
+        if (it == watches.wdToPath.end())
+          continue;
+        // Events on the directory itself (DELETE_SELF) dirty its parent.
+        std::string path = it->second;
+        if (event->mask & IN_DELETE_SELF) {
+          const size_t slash = path.find_last_of('/');
+          if (slash == std::string::npos)
+            continue;
+          path.resize(slash);
+        }
+        dirty.push_back(std::move(path));
+      }
+      continue; // drain until quiet before re-rendering
+    }
+
+    // Quiet period reached: re-list each dirty directory once, innermost
+    // duplicates folded into their shallowest dirty ancestor.
+    std::sort(dirty.begin(), dirty.end());
+    std::string last;
+    for (const std::string &path : dirty) {
+      if (!last.empty() && path.size() > last.size() &&
+          path.compare(0, last.size(), last) == 0 && path[last.size()] == '/')
+        continue; // covered by an ancestor's re-list
+      ScanNode *node = find_dir(scan.root, path);
+      if (!node)
+        continue; // subtree vanished; its parent's re-list covers it
+      resplice(scan, *node, opts, fd, watches);
+      last = path;
+    }
+    dirty.clear();
+
+    std::unordered_set<DevIno, DevInoHash> seen;
+    re_aggregate(scan.root, opts.diskUsage ? &seen : nullptr);
+    scan.totalFiles = scan.root.fileCount;
+    scan.totalLines = scan.root.lineCount;
+    scan.totalSize = scan.root.size;
+
+    render(scan, target, opts, out);
+  }
+
+  close(fd);
+  return 0;
+}
+
+} // namespace xtree
+
+#else // !__linux__
+
+namespace xtree {
+
+int run_watch(const fs::path &target, const Options &opts, OutputWriter &out) {
+  (void)target;
+  (void)opts;
+  (void)out;
+  std::cerr << "--watch requires Linux (inotify).\n";
+  return 2;
+}
+
+} // namespace xtree
+
+#endif
@@ -0,0 +1,111 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "xtree/writer.h"
+
+#include "xtree/profile.h"
+
+#include <cstdio>
+
+namespace xtree {
+
+namespace {
+
+const char *ansi_code(Color color) {
+  switch (color) {
+  case Color::Blue:
+    return "\033[1;34m";
+  case Color::Green:
+    return "\033[1;32m";
+  case Color::Gray:
+    return "\033[0;37m";
+  case Color::Red:
+    return "\033[1;31m";
+  case Color::Yellow:
+    return "\033[1;33m";
+  case Color::Magenta:
+    return "\033[1;35m";
+  case Color::Cyan:
+    return "\033[1;36m";
+  case Color::None:
+    break;
+  }
+  return "";
+}
+
+constexpr const char *kAnsiReset = "\033[0m";
+
+} // namespace
+
+OutputWriter::OutputWriter(size_t flushThreshold) : threshold_(flushThreshold) {
+  buf_.reserve(threshold_ + 512);
+}
+
+OutputWriter::~OutputWriter() {
+  flush();
+}
+
+OutputWriter &OutputWriter::write(std::string_view s) {
+  buf_.append(s);
+  maybe_flush();
+  return *this;
+}
+
+OutputWriter &OutputWriter::write(char c) {
+  buf_.push_back(c);
+  maybe_flush();
+  return *this;
+}
+
+OutputWriter &OutputWriter::colored(Color color, std::string_view s, bool useColor) {
+  if (useColor && color != Color::None) {
+    buf_.append(ansi_code(color));
+    buf_.append(s);
+    buf_.append(kAnsiReset);
+  } else {
+    buf_.append(s);
+  }
+  maybe_flush();
+  return *this;
+}
+
+OutputWriter &OutputWriter::annotation(Color color, std::string_view s, bool useColor) {
+  if (useColor && color != Color::None) {
+    buf_.append(" ");
+    buf_.append(ansi_code(color));
+    buf_.push_back('(');
+    buf_.append(s);
+    buf_.push_back(')');
+    buf_.append(kAnsiReset);
+  } else {
+    buf_.append(" (");
+    buf_.append(s);
+    buf_.push_back(')');
+  }
+  maybe_flush();
+  return *this;
+}
+
+void OutputWriter::flush() {
+  if (buf_.empty())
+    return;
+  if (prof::enabled)
+    prof::add_bytes(buf_.size());
+  prof::ScopedTimer timer(prof::Phase::Output);
+  std::fwrite(buf_.data(), 1, buf_.size(), stdout);
+  std::fflush(stdout);
+  buf_.clear();
+}
+
+void OutputWriter::maybe_flush() {
+  if (buf_.size() >= threshold_) {
+    if (prof::enabled)
+      prof::add_bytes(buf_.size());
+    prof::ScopedTimer timer(prof::Phase::Output);
+    std::fwrite(buf_.data(), 1, buf_.size(), stdout);
+    buf_.clear();
+  }
+}
+
+} // namespace xtree